@@ -26,6 +26,7 @@ class options:
     clean_build = False
     keep_cache = True
     debug = False
+    check = False # Compile the examples twice after the build and compare the objects, see check_determinism.py
 
 llvm_dir = os.environ.get("LLVM_DIR", "/usr/lib/llvm-17/lib/cmake/llvm")
 commands = {
@@ -37,8 +38,9 @@ commands = {
     "wasm-copy-js": "cp ./build/VIRELANG.js ./wasm-build/VIRELANG.js",
     "wasm-zip-wasm": "gzip -k --best -f ./VIRELANG.wasm",
     "cxx-run": "./VIRELANG",
-    "cxx-run-gen": "clang++ res/test.cpp test.o -o test -no-pie",
+    "cxx-run-gen": "clang++ test.o libvirert.a -o test -no-pie -pthread", # libvirert has `puti`, `putd` and the `@parallel` and profiling runtime
     "cxx-run-gen-exec": "./test",
+    "cxx-check": "python3 ./check_determinism.py ./build/VIRELANG",
 }
 build_types = {
     "--release": "Release",
@@ -96,6 +98,12 @@ def build_cxx(opts):
     print(f"{colors.OKGREEN}Executed {cmd_text}{colors.ENDC}")
     print(f"{colors.OKGREEN}Build succeeded{colors.ENDC}")
 
+    ##########
+    if opts.check:
+        print(f"{colors.OKGREEN}Checking that the examples compile to identical objects{colors.ENDC}")
+        if run_command(commands["cxx-check"].split(), run_verbose=True).returncode != 0:
+            sys.exit(1)
+
     ##########
     if opts.run_argument == "none":
         return
@@ -192,6 +200,9 @@ def main():
     if ("-dbg" in sys.argv) or ("--debug" in sys.argv):
         opts.debug=True
 
+    if ("--check" in sys.argv) or ("-chk" in sys.argv):
+        opts.check=True
+
     build_entry(opts)
 
 if(__name__ == "__main__"):
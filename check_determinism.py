@@ -0,0 +1,66 @@
+#!/usr/bin/python3
+
+# Compiles every example twice, each time in a directory of its own, and checks that the objects are byte for byte the same
+# The second compile runs with a larger environment, which moves the stack and the heap, so output that depends on
+# addresses or on the order of hashed containers shows up as a difference
+# Usage: ./check_determinism.py [path to VIRELANG], by default the executable `build.py` builds in ./build
+
+import os
+import sys
+import shutil
+import filecmp
+import tempfile
+import subprocess
+
+class colors:
+    OKGREEN = '\033[92m'
+    FAIL = '\033[91m'
+    ENDC = '\033[0m'
+    BOLD = '\033[1m'
+
+def compile_example(compiler, example, work_dir, env=None):
+    # VIRELANG compiles `res/test.ve` of its working directory to `test.o`
+    os.makedirs(os.path.join(work_dir, "res"))
+    shutil.copy(example, os.path.join(work_dir, "res", "test.ve"))
+
+    result = subprocess.run([compiler], cwd=work_dir, env=env, stdout=subprocess.DEVNULL, stderr=subprocess.STDOUT)
+    object_path = os.path.join(work_dir, "test.o")
+    if result.returncode != 0 or not os.path.exists(object_path):
+        return None
+    return object_path
+
+def main():
+    compiler = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else "./build/VIRELANG")
+    if not os.path.exists(compiler):
+        print(f"{colors.FAIL}{compiler} not found, build it with `build.py -c` first{colors.ENDC}")
+        return 1
+
+    examples_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "examples")
+    examples = sorted(name for name in os.listdir(examples_dir) if name.endswith(".ve"))
+
+    shifted_env = dict(os.environ, VIRE_DETERMINISM_PADDING="x" * 4096)
+
+    failed = 0
+    for name in examples:
+        example = os.path.join(examples_dir, name)
+        with tempfile.TemporaryDirectory() as first_dir, tempfile.TemporaryDirectory() as second_dir:
+            first = compile_example(compiler, example, first_dir)
+            second = compile_example(compiler, example, second_dir, shifted_env)
+
+            if first is None or second is None:
+                print(f"{colors.FAIL}{name}: compilation failed{colors.ENDC}")
+                failed += 1
+            elif not filecmp.cmp(first, second, shallow=False):
+                print(f"{colors.FAIL}{name}: the two objects differ{colors.ENDC}")
+                failed += 1
+            else:
+                print(f"{colors.OKGREEN}{name}: identical{colors.ENDC}")
+
+    if failed:
+        print(f"{colors.FAIL}{colors.BOLD}{failed} of {len(examples)} examples are not reproducible{colors.ENDC}")
+        return 1
+    print(f"{colors.OKGREEN}{colors.BOLD}All {len(examples)} examples compile to identical objects{colors.ENDC}")
+    return 0
+
+if(__name__ == "__main__"):
+    sys.exit(main())
@@ -0,0 +1,21 @@
+add_executable(
+    vire-lsp
+
+    ${SRC_DIR}/src/lsp/server.hpp
+    ${SRC_DIR}/src/lsp/server.cpp
+    ${SRC_DIR}/src/lsp/main.cpp
+)
+
+# The language server keeps the same libraries resident as the compiler does
+target_link_libraries(
+    vire-lsp PRIVATE
+
+    vire-api
+    vire-pconfig
+    vire-parser
+    vire-proto-file
+    vire-analyzer
+    vire-error-builder
+    vire-compiler
+    vire-serial
+)
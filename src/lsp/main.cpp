@@ -0,0 +1,34 @@
+#include "server.hpp"
+
+#include <iostream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+int main()
+{
+    // The protocol owns stdout, what the compiler prints outside of a check goes to stderr
+    std::FILE* out=stdout;
+#ifndef _WIN32
+    out=fdopen(dup(STDOUT_FILENO), "w");
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+#endif
+
+    std::ios::sync_with_stdio(false);
+    vire::lsp::LanguageServer server(out);
+
+    std::string content;
+    while(!server.isExitRequested() && server.readMessage(content))
+    {
+        auto message=llvm::json::parse(content);
+        if(!message)
+        {
+            llvm::consumeError(message.takeError());
+            continue;
+        }
+        server.handle(*message);
+    }
+
+    return server.isShutdownRequested() ? 0 : 1;
+}
@@ -0,0 +1,867 @@
+#include "server.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <cctype>
+#include <charconv>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace vire
+{
+namespace lsp
+{
+    // The compiler reports problems on stdout, the output of `run` is collected line by line from a temporary file
+    static std::vector<std::string> captureOutput(std::function<void()> const& run)
+    {
+        std::vector<std::string> lines;
+    #ifndef _WIN32
+        std::fflush(stdout);
+        std::cout.flush();
+
+        std::FILE* capture=std::tmpfile();
+        if(!capture)
+        {
+            run();
+            return lines;
+        }
+
+        int saved=dup(STDOUT_FILENO);
+        dup2(fileno(capture), STDOUT_FILENO);
+        run();
+        std::fflush(stdout);
+        std::cout.flush();
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+
+        std::rewind(capture);
+        std::string line;
+        for(int c=std::fgetc(capture); c!=EOF; c=std::fgetc(capture))
+        {
+            if(c=='\n')
+            {
+                if(!line.empty())
+                    lines.push_back(line);
+                line.clear();
+            }
+            else
+            {
+                line.push_back((char)c);
+            }
+        }
+        if(!line.empty())
+            lines.push_back(line);
+        std::fclose(capture);
+    #else
+        run();
+    #endif
+        return lines;
+    }
+
+    static std::string uriToPath(std::string const& uri)
+    {
+        std::string path=uri.rfind("file://", 0)==0 ? uri.substr(7) : uri;
+
+        std::string decoded;
+        for(std::size_t i=0; i<path.size(); i++)
+        {
+            // An escape that is not two hex digits is kept as it is
+            if(path[i]=='%' && i+2<path.size() && std::isxdigit((unsigned char)path[i+1]) && std::isxdigit((unsigned char)path[i+2]))
+            {
+                decoded.push_back((char)std::stoi(path.substr(i+1, 2), nullptr, 16));
+                i+=2;
+            }
+            else
+            {
+                decoded.push_back(path[i]);
+            }
+        }
+        return decoded;
+    }
+
+    // Lines end with "\n", "\r\n" or "\r" for the protocol
+    static std::vector<std::string> splitLines(std::string const& text)
+    {
+        std::vector<std::string> lines(1);
+        for(std::size_t i=0; i<text.size(); i++)
+        {
+            if(text[i]=='\r' || text[i]=='\n')
+            {
+                if(text[i]=='\r' && i+1<text.size() && text[i+1]=='\n')
+                    i++;
+                lines.emplace_back();
+            }
+            else
+            {
+                lines.back().push_back(text[i]);
+            }
+        }
+        return lines;
+    }
+    static std::size_t getOffset(std::string const& text, std::size_t line, std::size_t character)
+    {
+        std::size_t offset=0;
+        for(; line>0 && offset<text.size(); offset++)
+        {
+            if(text[offset]=='\n' || (text[offset]=='\r' && (offset+1==text.size() || text[offset+1]!='\n')))
+                line--;
+        }
+        for(; character>0 && offset<text.size() && text[offset]!='\n' && text[offset]!='\r'; character--)
+            offset++;
+        return offset;
+    }
+
+    static bool isIdentifierChar(char c)
+    {
+        return std::isalnum((unsigned char)c) || c=='_';
+    }
+
+    // Cursor - The identifier at a position and the `a.b.` member chain in front of it
+    struct Cursor
+    {
+        std::size_t line;
+        std::string word;
+        std::vector<std::string> chain;
+        bool is_member;
+    };
+    static Cursor getCursor(std::string const& text, llvm::json::Object const& params)
+    {
+        Cursor cursor{0, "", {}, false};
+
+        auto* position=params.getObject("position");
+        if(!position)
+            return cursor;
+        cursor.line=position->getInteger("line").value_or(0);
+        std::size_t character=position->getInteger("character").value_or(0);
+
+        auto lines=splitLines(text);
+        if(cursor.line>=lines.size())
+            return cursor;
+        auto const& line=lines[cursor.line];
+        character=std::min(character, line.size());
+
+        std::size_t begin=character, end=character;
+        while(begin>0 && isIdentifierChar(line[begin-1]))  begin--;
+        while(end<line.size() && isIdentifierChar(line[end]))  end++;
+        cursor.word=line.substr(begin, end-begin);
+
+        while(begin>0 && line[begin-1]=='.')
+        {
+            cursor.is_member=true;
+            std::size_t prev_end=begin-1;
+            begin=prev_end;
+            while(begin>0 && isIdentifierChar(line[begin-1]))  begin--;
+            if(begin==prev_end)
+                break;
+            cursor.chain.insert(cursor.chain.begin(), line.substr(begin, prev_end-begin));
+        }
+        return cursor;
+    }
+
+    static std::string typeToString(types::Base* const type)
+    {
+        if(!type)
+            return "void";
+
+        switch(type->getType())
+        {
+            case types::EType::Array:
+            {
+                auto* arr=(types::Array*)type;
+                return typeToString(arr->getChild())+"["+std::to_string(arr->getLength())+"]";
+            }
+            case types::EType::Custom:
+            {
+                // Struct types are named with the prefix of their identifier
+                auto const& name=((types::Custom*)type)->getName();
+                return name.rfind("_", 0)==0 ? name.substr(1) : name;
+            }
+            case types::EType::Void:
+            {
+                auto const& name=((types::Void*)type)->getName();
+                return name.empty() ? "void" : (name.rfind("_", 0)==0 ? name.substr(1) : name);
+            }
+            default:
+                return types::getMapFromType(type->getType());
+        }
+    }
+
+    // A variable without a written type takes the one of its value, `VAnalyzer::getType` infers that
+    static types::Base* getVariableType(VAnalyzer* const analyzer, VariableDefAST* const var)
+    {
+        auto* type=var->getType();
+        bool inferred=type && type->getType()==types::EType::Void && ((types::Void*)type)->getName().empty();
+        if((!type || inferred) && var->getValue())
+            return analyzer->getType(var->getValue());
+        return type;
+    }
+
+    static std::string functionSignature(FunctionBaseAST* const func)
+    {
+        std::string signature=func->is_extern() ? "extern " : "func ";
+        signature+=func->getIName().name+"(";
+
+        bool first=true;
+        for(auto const& arg : func->getArgs())
+        {
+            if(arg->getIName().name=="self")
+                continue;
+
+            if(!first)  signature+=", ";
+            signature+=arg->getIName().name+": "+(arg->isReference() ? "&" : "")+typeToString(arg->getType());
+            first=false;
+        }
+        signature+=")";
+
+        if(func->getReturnType() && func->getReturnType()->getType()!=types::EType::Void)
+            signature+=" returns "+typeToString(func->getReturnType());
+        return signature;
+    }
+    static std::string typeSignature(TypeAST* const type, std::string const& indent="")
+    {
+        std::string signature=(type->asttype==ast_union ? "union " : "struct ")+type->getIName().name+" {\n";
+        for(auto const& iname : type->getMembersOrder())
+        {
+            auto* member=type->getMember(iname);
+            if(member->asttype==ast_struct || member->asttype==ast_union)
+                signature+=indent+"    "+typeSignature((TypeAST*)member, indent+"    ");
+            else
+                signature+=indent+"    "+typeToString(member->getType())+" "+iname.name+";\n";
+        }
+        return signature+indent+"}\n";
+    }
+
+    // Lookups in the verified module, by the name as it is written in the source
+
+    static FunctionBaseAST* findFunction(ModuleAST* const mod, std::string const& name)
+    {
+        for(auto const& func : mod->getFunctions())
+        {
+            if(func->getIName().name==name)
+                return func.get();
+        }
+        return nullptr;
+    }
+    static TypeAST* findType(ModuleAST* const mod, std::string const& name)
+    {
+        for(auto const& type : mod->getUnionStructs())
+        {
+            auto* type_ast=(TypeAST*)type.get();
+            if(type_ast->getIName().name==name || type_ast->getName()==name)
+                return type_ast;
+        }
+        return nullptr;
+    }
+    // The function with the last name token before `line`, functions do not nest
+    static FunctionAST* findEnclosingFunction(ModuleAST* const mod, std::size_t line)
+    {
+        FunctionAST* enclosing=nullptr;
+        for(auto const& func : mod->getFunctions())
+        {
+            if(func->is_proto() || func->is_extern() || !func->getNameToken())
+                continue;
+
+            auto func_line=func->getNameToken()->line;
+            if(func_line<=line && (!enclosing || func_line>=enclosing->getNameToken()->line))
+                enclosing=(FunctionAST*)func.get();
+        }
+        return enclosing;
+    }
+    static void collectVariables(std::vector<std::unique_ptr<ExprAST>> const& block, std::size_t line, std::vector<VariableDefAST*>& vars)
+    {
+        for(auto const& expr : block)
+        {
+            if(!expr)
+                continue;
+
+            switch(expr->asttype)
+            {
+                case ast_vardef:
+                    if(expr->getToken() && expr->getLine()<=line)
+                        vars.push_back((VariableDefAST*)expr.get());
+                    break;
+                case ast_for:
+                {
+                    auto* for_=(ForExprAST*)expr.get();
+                    if(for_->getInit() && for_->getInit()->asttype==ast_vardef && for_->getInit()->getToken() && for_->getInit()->getLine()<=line)
+                        vars.push_back((VariableDefAST*)for_->getInit());
+                    collectVariables(for_->getBody(), line, vars);
+                    break;
+                }
+                case ast_while:
+                    collectVariables(((WhileExprAST*)expr.get())->getBody(), line, vars);
+                    break;
+                case ast_unsafe:
+                    collectVariables(((UnsafeExprAST*)expr.get())->getBody(), line, vars);
+                    break;
+                case ast_ifelse:
+                {
+                    auto* if_=(IfExprAST*)expr.get();
+                    collectVariables(if_->getThenBlock(), line, vars);
+                    for(auto const& elif : if_->getElifLadder())
+                    {
+                        collectVariables(elif->getThenBlock(), line, vars);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+    // The variables visible at `line`, later definitions shadow the earlier ones
+    static std::vector<VariableDefAST*> getVisibleVariables(ModuleAST* const mod, std::size_t line)
+    {
+        std::vector<VariableDefAST*> vars;
+        collectVariables(mod->getPreExecutionStatements(), line, vars);
+
+        if(auto* func=findEnclosingFunction(mod, line))
+        {
+            for(auto const& arg : func->getArgs())
+            {
+                vars.push_back(arg.get());
+            }
+            collectVariables(func->getBody(), line, vars);
+        }
+        return vars;
+    }
+    static VariableDefAST* findVariable(ModuleAST* const mod, std::size_t line, std::string const& name)
+    {
+        auto vars=getVisibleVariables(mod, line);
+        for(auto it=vars.rbegin(); it!=vars.rend(); it++)
+        {
+            if((*it)->getIName().name==name)
+                return *it;
+        }
+        return nullptr;
+    }
+    static ExprAST* findMember(TypeAST* const type, std::string const& name)
+    {
+        for(auto const& iname : type->getMembersOrder())
+        {
+            if(iname.name==name)
+                return type->getMember(iname);
+        }
+        return nullptr;
+    }
+    // The struct or union that the member chain `a.b` in front of the cursor evaluates to
+    static TypeAST* resolveChain(VAnalyzer* const analyzer, ModuleAST* const mod, Cursor const& cursor)
+    {
+        if(cursor.chain.empty())
+            return nullptr;
+
+        ExprAST* value=findVariable(mod, cursor.line, cursor.chain[0]);
+        for(std::size_t i=0; value; i++)
+        {
+            TypeAST* type=nullptr;
+            if(value->asttype==ast_struct || value->asttype==ast_union)
+            {
+                type=(TypeAST*)value;
+            }
+            else if(auto* ty=value->asttype==ast_vardef ? getVariableType(analyzer, (VariableDefAST*)value) : value->getType())
+            {
+                if(ty->getType()==types::EType::Custom)
+                    type=findType(mod, ((types::Custom*)ty)->getName());
+                else if(ty->getType()==types::EType::Void)
+                    type=findType(mod, ((types::Void*)ty)->getName());
+            }
+
+            if(!type || i+1==cursor.chain.size())
+                return type;
+            value=findMember(type, cursor.chain[i+1]);
+        }
+        return nullptr;
+    }
+
+    static llvm::json::Object makeRange(std::size_t line, std::size_t begin, std::size_t end)
+    {
+        return llvm::json::Object{
+            {"start", llvm::json::Object{{"line", (int64_t)line}, {"character", (int64_t)begin}}},
+            {"end", llvm::json::Object{{"line", (int64_t)line}, {"character", (int64_t)end}}},
+        };
+    }
+    // Token columns are not the columns of the editor, the name is looked up in its line instead
+    static llvm::json::Object makeLocation(Document* const doc, VToken* const token, std::string const& name)
+    {
+        std::size_t line=token ? token->line : 0;
+        std::size_t column=0;
+
+        auto lines=splitLines(doc->getText());
+        if(line<lines.size())
+        {
+            auto const& text=lines[line];
+            for(auto pos=text.find(name); pos!=std::string::npos; pos=text.find(name, pos+1))
+            {
+                bool starts=pos==0 || !isIdentifierChar(text[pos-1]);
+                bool ends=pos+name.size()==text.size() || !isIdentifierChar(text[pos+name.size()]);
+                if(starts && ends)
+                {
+                    column=pos;
+                    break;
+                }
+            }
+        }
+        return llvm::json::Object{{"uri", doc->getURI()}, {"range", makeRange(line, column, column+name.size())}};
+    }
+
+    Document::Document(std::string const& uri, std::string const& text)
+    : uri(uri), text(text)
+    {
+        current=VApi::loadFromText("");
+        spare=VApi::loadFromText("");
+        current->setSourcePath(uriToPath(uri));
+        spare->setSourcePath(uriToPath(uri));
+        update();
+    }
+
+    void Document::update()
+    {
+        // The lexer counts "\r\n" as two lines, the compiled copy only uses '\n' so lines match the editor
+        std::string code;
+        code.reserve(text.size());
+        for(std::size_t i=0; i<text.size(); i++)
+        {
+            if(text[i]=='\r')
+            {
+                if(i+1<text.size() && text[i+1]=='\n')
+                    continue;
+                code.push_back('\n');
+            }
+            else
+            {
+                code.push_back(text[i]);
+            }
+        }
+
+        bool parsed=false;
+        messages=captureOutput([&]() {
+            if(spare->reparseSourceModule(code))
+            {
+                spare->verifySourceModule();
+                std::swap(current, spare);
+                parsed=true;
+            }
+        });
+        diagnostics=(parsed ? current : spare)->getErrorBuilder()->getDiagnostics();
+    }
+    void Document::applyChange(llvm::json::Object const& change)
+    {
+        auto new_text=change.getString("text").value_or("").str();
+
+        auto* range=change.getObject("range");
+        if(!range || !range->getObject("start") || !range->getObject("end"))
+        {
+            text=new_text;
+            return;
+        }
+
+        auto* start=range->getObject("start");
+        auto* end=range->getObject("end");
+        auto begin_offset=getOffset(text, start->getInteger("line").value_or(0), start->getInteger("character").value_or(0));
+        auto end_offset=getOffset(text, end->getInteger("line").value_or(0), end->getInteger("character").value_or(0));
+        text.replace(begin_offset, std::max(begin_offset, end_offset)-begin_offset, new_text);
+    }
+
+    void Document::restoreCustomTypes() const
+    {
+        current->restoreCustomTypes();
+    }
+
+    VAnalyzer* const Document::getAnalyzer() const
+    {
+        return current->getCompiler()->getAnalyzer();
+    }
+    ModuleAST* const Document::getModule() const
+    {
+        return getAnalyzer()->getSourceModule();
+    }
+
+    LanguageServer::LanguageServer(std::FILE* out)
+    : out(out), shutdown_requested(false), exit_requested(false)
+    {
+        Config config;
+        config.installDefaultKeywords();
+        for(auto const& [keyword, tok] : config.KeywordTokenMap)
+        {
+            keywords.push_back(keyword);
+        }
+        std::sort(keywords.begin(), keywords.end());
+    }
+
+    // Frames without a valid Content-Length are skipped, only the end of the input stops the server
+    bool LanguageServer::readMessage(std::string& content)
+    {
+        while(std::cin)
+        {
+            std::size_t length=0;
+            std::string header;
+            while(std::getline(std::cin, header))
+            {
+                if(!header.empty() && header.back()=='\r')
+                    header.pop_back();
+                if(header.empty())
+                    break;
+
+                // Searched in the whole line, the body of a skipped frame has no line ending and prefixes the next header
+                auto pos=header.find("Content-Length:");
+                if(pos==std::string::npos)
+                    continue;
+
+                auto const* begin=header.data()+pos+15;
+                auto const* end=header.data()+header.size();
+                while(begin<end && *begin==' ')
+                    ++begin;
+
+                auto [ptr, ec]=std::from_chars(begin, end, length);
+                if(ec!=std::errc() || ptr!=end)
+                    length=0;
+            }
+            if(!std::cin)
+                return false;
+
+            if(length==0)
+            {
+                std::cerr << "LSP: skipped a frame without a valid Content-Length" << std::endl;
+                continue;
+            }
+
+            content.resize(length);
+            std::cin.read(content.data(), length);
+            return (bool)std::cin;
+        }
+        return false;
+    }
+    void LanguageServer::send(llvm::json::Value message)
+    {
+        std::string content;
+        llvm::raw_string_ostream os(content);
+        os << message;
+        os.flush();
+
+        std::fprintf(out, "Content-Length: %zu\r\n\r\n", content.size());
+        std::fwrite(content.data(), 1, content.size(), out);
+        std::fflush(out);
+    }
+    void LanguageServer::reply(llvm::json::Value const& id, llvm::json::Value result)
+    {
+        send(llvm::json::Object{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+    }
+    void LanguageServer::replyError(llvm::json::Value const& id, int code, std::string const& message)
+    {
+        send(llvm::json::Object{{"jsonrpc", "2.0"}, {"id", id}, {"error", llvm::json::Object{{"code", code}, {"message", message}}}});
+    }
+    void LanguageServer::publishDiagnostics(Document* const doc)
+    {
+        llvm::json::Array diagnostics;
+        for(auto const& diagnostic : doc->getDiagnostics())
+        {
+            std::string message=diagnostic.message;
+            for(auto const& note : diagnostic.notes)
+            {
+                message+="\n"+note;
+            }
+
+            int severity=1;
+            if(diagnostic.severity==errors::Severity::warning)   severity=2;
+            else if(diagnostic.severity==errors::Severity::note) severity=3;
+
+            diagnostics.push_back(llvm::json::Object{
+                {"range", makeRange(diagnostic.line, diagnostic.column, diagnostic.column+diagnostic.length)},
+                {"severity", severity},
+                {"source", "vire"},
+                {"code", errors::errortypeToStr(diagnostic.code)},
+                {"message", std::move(message)},
+            });
+        }
+
+        // The other messages of the compiler carry no position, they are reported at the start of the document
+        for(auto const& message : doc->getMessages())
+        {
+            std::string lower=message;
+            std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+
+            diagnostics.push_back(llvm::json::Object{
+                {"range", makeRange(0, 0, 0)},
+                {"severity", lower.find("warning")!=std::string::npos ? 2 : 1},
+                {"source", "vire"},
+                {"message", message},
+            });
+        }
+
+        send(llvm::json::Object{
+            {"jsonrpc", "2.0"},
+            {"method", "textDocument/publishDiagnostics"},
+            {"params", llvm::json::Object{{"uri", doc->getURI()}, {"diagnostics", std::move(diagnostics)}}},
+        });
+    }
+
+    Document* const LanguageServer::getDocument(llvm::json::Object const& params)
+    {
+        auto* text_document=params.getObject("textDocument");
+        if(!text_document)
+            return nullptr;
+
+        auto uri=text_document->getString("uri");
+        if(!uri)
+            return nullptr;
+
+        auto it=documents.find(uri->str());
+        if(it==documents.end())
+            return nullptr;
+
+        // Every document verifies its structs into the same global types, a request is served with the ones of its document
+        it->second->restoreCustomTypes();
+        return it->second.get();
+    }
+
+    llvm::json::Value LanguageServer::initialize()
+    {
+        return llvm::json::Object{
+            {"capabilities", llvm::json::Object{
+                {"textDocumentSync", 2}, // incremental
+                {"hoverProvider", true},
+                {"definitionProvider", true},
+                {"completionProvider", llvm::json::Object{{"triggerCharacters", llvm::json::Array{"."}}}},
+            }},
+            {"serverInfo", llvm::json::Object{{"name", "vire-lsp"}}},
+        };
+    }
+
+    llvm::json::Value LanguageServer::hover(llvm::json::Object const& params)
+    {
+        auto* doc=getDocument(params);
+        if(!doc || !doc->getModule())
+            return nullptr;
+
+        auto* mod=doc->getModule();
+        auto cursor=getCursor(doc->getText(), params);
+        if(cursor.word.empty())
+            return nullptr;
+
+        std::string contents;
+        if(cursor.is_member)
+        {
+            auto* type=resolveChain(doc->getAnalyzer(), mod, cursor);
+            auto* member=type ? findMember(type, cursor.word) : nullptr;
+            if(member && (member->asttype==ast_struct || member->asttype==ast_union))
+                contents=typeSignature((TypeAST*)member);
+            else if(member)
+                contents=typeToString(member->getType())+" "+cursor.word;
+        }
+        else if(auto* var=findVariable(mod, cursor.line, cursor.word))
+        {
+            contents=std::string(var->isConst() ? "const " : "let ")+cursor.word+": "+typeToString(getVariableType(doc->getAnalyzer(), var));
+        }
+        else if(auto* func=findFunction(mod, cursor.word))
+        {
+            contents=functionSignature(func);
+        }
+        else if(auto* type=findType(mod, cursor.word))
+        {
+            contents=typeSignature(type);
+        }
+
+        if(contents.empty())
+            return nullptr;
+
+        return llvm::json::Object{
+            {"contents", llvm::json::Object{{"kind", "markdown"}, {"value", "```vire\n"+contents+"\n```"}}},
+        };
+    }
+
+    llvm::json::Value LanguageServer::definition(llvm::json::Object const& params)
+    {
+        auto* doc=getDocument(params);
+        if(!doc || !doc->getModule())
+            return nullptr;
+
+        auto* mod=doc->getModule();
+        auto cursor=getCursor(doc->getText(), params);
+        if(cursor.word.empty())
+            return nullptr;
+
+        if(cursor.is_member)
+        {
+            auto* type=resolveChain(doc->getAnalyzer(), mod, cursor);
+            auto* member=type ? findMember(type, cursor.word) : nullptr;
+            if(member && (member->asttype==ast_struct || member->asttype==ast_union))
+                return makeLocation(doc, ((TypeAST*)member)->getNameToken(), cursor.word);
+            if(member && member->getToken())
+                return makeLocation(doc, member->getToken(), cursor.word);
+            return nullptr;
+        }
+
+        if(auto* var=findVariable(mod, cursor.line, cursor.word))
+        {
+            if(var->getToken())
+                return makeLocation(doc, var->getToken(), cursor.word);
+        }
+        // Imported declarations have no position in this document
+        if(auto* func=findFunction(mod, cursor.word))
+        {
+            if(func->getNameToken() && func->getNameToken()->value==cursor.word)
+                return makeLocation(doc, func->getNameToken(), cursor.word);
+        }
+        if(auto* type=findType(mod, cursor.word))
+        {
+            if(type->getNameToken() && !(type->asttype==ast_struct && ((StructExprAST*)type)->isImported()))
+                return makeLocation(doc, type->getNameToken(), cursor.word);
+        }
+        return nullptr;
+    }
+
+    llvm::json::Value LanguageServer::completion(llvm::json::Object const& params)
+    {
+        // Completion item kinds of the protocol
+        enum CompletionKind { kind_function=3, kind_field=5, kind_variable=6, kind_keyword=14, kind_struct=22 };
+
+        llvm::json::Array items;
+        auto add=[&](std::string const& label, int kind, std::string const& detail) {
+            items.push_back(llvm::json::Object{{"label", label}, {"kind", kind}, {"detail", detail}});
+        };
+
+        auto* doc=getDocument(params);
+        auto* mod=doc ? doc->getModule() : nullptr;
+        auto cursor=doc ? getCursor(doc->getText(), params) : Cursor{0, "", {}, false};
+
+        if(mod && cursor.is_member)
+        {
+            if(auto* type=resolveChain(doc->getAnalyzer(), mod, cursor))
+            {
+                for(auto const& iname : type->getMembersOrder())
+                {
+                    auto* member=type->getMember(iname);
+                    bool is_type=member->asttype==ast_struct || member->asttype==ast_union;
+                    add(iname.name, kind_field, is_type ? "struct" : typeToString(member->getType()));
+                }
+            }
+            return llvm::json::Object{{"isIncomplete", false}, {"items", std::move(items)}};
+        }
+
+        for(auto const& keyword : keywords)
+        {
+            add(keyword, kind_keyword, "keyword");
+        }
+        if(mod)
+        {
+            std::unordered_map<std::string, bool> added;
+            auto vars=getVisibleVariables(mod, cursor.line);
+            for(auto it=vars.rbegin(); it!=vars.rend(); it++)
+            {
+                auto const& name=(*it)->getIName().name;
+                if(added.count(name)>0)
+                    continue;
+                added[name]=true;
+                add(name, kind_variable, typeToString(getVariableType(doc->getAnalyzer(), *it)));
+            }
+            // Outlined functions (`name.suffix`) are not written by the user
+            for(auto const& func : mod->getFunctions())
+            {
+                if(func->getIName().name.find('.')==std::string::npos)
+                    add(func->getIName().name, kind_function, functionSignature(func.get()));
+            }
+            for(auto const& type : mod->getUnionStructs())
+            {
+                add(((TypeAST*)type.get())->getIName().name, kind_struct, type->asttype==ast_union ? "union" : "struct");
+            }
+        }
+        return llvm::json::Object{{"isIncomplete", false}, {"items", std::move(items)}};
+    }
+
+    void LanguageServer::handle(llvm::json::Value const& message)
+    {
+        auto* obj=message.getAsObject();
+        if(!obj)
+            return;
+
+        auto method=obj->getString("method");
+        auto* id=obj->get("id");
+        auto* params=obj->getObject("params");
+        llvm::json::Object empty;
+        if(!params)
+            params=&empty;
+
+        if(!method)
+            return;
+
+        // Requests are answered with their id, notifications have none
+        bool is_request=id!=nullptr;
+        if(!is_request && (*method=="initialize" || *method=="shutdown" || *method=="textDocument/hover" 
+            || *method=="textDocument/definition" || *method=="textDocument/completion"))
+            return;
+
+        if(*method=="initialize")
+        {
+            reply(*id, initialize());
+        }
+        else if(*method=="shutdown")
+        {
+            shutdown_requested=true;
+            reply(*id, nullptr);
+        }
+        else if(*method=="exit")
+        {
+            exit_requested=true;
+        }
+        else if(*method=="textDocument/didOpen")
+        {
+            auto* text_document=params->getObject("textDocument");
+            if(!text_document)
+                return;
+
+            auto uri=text_document->getString("uri").value_or("").str();
+            auto text=text_document->getString("text").value_or("").str();
+            documents[uri]=std::make_unique<Document>(uri, text);
+            publishDiagnostics(documents[uri].get());
+        }
+        else if(*method=="textDocument/didChange")
+        {
+            auto* doc=getDocument(*params);
+            auto* changes=params->getArray("contentChanges");
+            if(!doc || !changes)
+                return;
+
+            for(auto const& change : *changes)
+            {
+                if(auto* change_obj=change.getAsObject())
+                    doc->applyChange(*change_obj);
+            }
+            doc->update();
+            publishDiagnostics(doc);
+        }
+        else if(*method=="textDocument/didClose")
+        {
+            auto* doc=getDocument(*params);
+            if(!doc)
+                return;
+
+            auto uri=doc->getURI();
+            send(llvm::json::Object{
+                {"jsonrpc", "2.0"},
+                {"method", "textDocument/publishDiagnostics"},
+                {"params", llvm::json::Object{{"uri", uri}, {"diagnostics", llvm::json::Array()}}},
+            });
+            documents.erase(uri);
+        }
+        else if(*method=="textDocument/hover")
+        {
+            reply(*id, hover(*params));
+        }
+        else if(*method=="textDocument/definition")
+        {
+            reply(*id, definition(*params));
+        }
+        else if(*method=="textDocument/completion")
+        {
+            reply(*id, completion(*params));
+        }
+        else if(is_request)
+        {
+            replyError(*id, -32601, "Method not found: "+method->str());
+        }
+    }
+}
+}
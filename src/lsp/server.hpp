@@ -0,0 +1,80 @@
+#pragma once
+
+#include "vire/includes.hpp"
+
+#include "llvm/Support/JSON.h"
+
+#include <cstdio>
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+namespace vire
+{
+namespace lsp
+{
+
+// Document - An open source file and the compiler state of its latest version that parsed
+// Two `VApi`s are kept, a version that does not parse is checked on the spare one so the symbols of the last good version stay available
+class Document
+{
+    std::string uri;
+    std::string text;
+    std::unique_ptr<VApi> current;
+    std::unique_ptr<VApi> spare;
+    std::vector<std::string> messages;
+    std::vector<errors::Diagnostic> diagnostics; // the parse errors of the latest version, with their positions
+public:
+    Document(std::string const& uri, std::string const& text);
+
+    // Parses and verifies the text again, only the declarations that changed are parsed
+    void update();
+    void applyChange(llvm::json::Object const& change);
+
+    std::string const& getURI() const { return uri; }
+    std::string const& getText() const { return text; }
+    std::vector<std::string> const& getMessages() const { return messages; }
+    std::vector<errors::Diagnostic> const& getDiagnostics() const { return diagnostics; }
+
+    // The struct types of the last version that parsed become the current ones, other documents may have replaced them
+    void restoreCustomTypes() const;
+
+    // nullptr until a version of the document parsed
+    VAnalyzer* const getAnalyzer() const;
+    ModuleAST* const getModule() const;
+};
+
+// LanguageServer - Serves the Language Server Protocol over stdin/stdout from documents that stay resident between requests
+class LanguageServer
+{
+    std::FILE* out;
+    std::unordered_map<std::string, std::unique_ptr<Document>> documents;
+    std::vector<std::string> keywords;
+    bool shutdown_requested;
+    bool exit_requested;
+
+    void send(llvm::json::Value message);
+    void reply(llvm::json::Value const& id, llvm::json::Value result);
+    void replyError(llvm::json::Value const& id, int code, std::string const& message);
+    void publishDiagnostics(Document* const doc);
+
+    Document* const getDocument(llvm::json::Object const& params);
+
+    llvm::json::Value initialize();
+    llvm::json::Value hover(llvm::json::Object const& params);
+    llvm::json::Value definition(llvm::json::Object const& params);
+    llvm::json::Value completion(llvm::json::Object const& params);
+public:
+    // `out` is where the protocol is written, the compiler itself writes its messages to stdout
+    LanguageServer(std::FILE* out);
+
+    void handle(llvm::json::Value const& message);
+    bool readMessage(std::string& content);
+
+    bool isExitRequested() const { return exit_requested; }
+    bool isShutdownRequested() const { return shutdown_requested; }
+};
+
+}
+}
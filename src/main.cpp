@@ -3,12 +3,18 @@
 #include <iostream>
 #include <ostream>
 #include <memory>
+#include <string>
 
-int entry()
+int entry(bool jit, bool perf_map)
 {
     auto api=vire::VApi::loadFromFile("res/test.ve", "sys");
 
-    api->parseSourceModule();
+    if(!api->parseSourceModule())
+    {
+        api->showErrors();
+        std::cout << "Parsing failed" << std::endl;
+        return 1;
+    }
     
     bool s=api->verifySourceModule();
     if(!s)
@@ -17,6 +23,14 @@ int entry()
         return 1;
     }
 
+#ifndef VIRE_USE_EMCC
+    if(jit)
+    {
+        api->setPerfMap(perf_map);
+        return api->runSourceModule(vire::Optimization::O3);
+    }
+#endif
+
     s=api->compileSourceModule("./test.o", true, vire::Optimization::O3);
     api->getErrorBuilder()->showErrors();
     if(!s)
@@ -32,10 +46,19 @@ int entry()
 }
 
 #ifndef VIRE_USE_EMCC
-int main()
+// `--jit` runs the program in this process instead of writing `test.o`, `--perf-map` names its functions for `perf`
+int main(int argc, char** argv)
 {
+    bool jit=false, perf_map=false;
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg=argv[i];
+        if(arg=="--jit")            jit=true;
+        else if(arg=="--perf-map")  perf_map=true;
+    }
+
     int ret=0;
-    ret=entry();
+    ret=entry(jit, perf_map);
 
     return ret;
 }
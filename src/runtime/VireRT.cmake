@@ -0,0 +1,23 @@
+find_package(Threads REQUIRED)
+
+add_library(
+    virert STATIC
+
+    ${SRC_DIR}/src/runtime/virert.h
+    ${SRC_DIR}/src/runtime/io.cpp
+    ${SRC_DIR}/src/runtime/memory.cpp
+    ${SRC_DIR}/src/runtime/math.cpp
+    ${SRC_DIR}/src/runtime/parallel.cpp
+    ${SRC_DIR}/src/runtime/profile.cpp
+)
+
+# The runtime does not depend on LLVM, it is linked into the compiled programs
+set_target_properties(virert PROPERTIES LINK_LIBRARIES "")
+target_compile_options(virert PRIVATE -O3 -fno-math-errno)
+target_link_libraries(virert PUBLIC Threads::Threads)
+
+# `VIRELANG --jit` runs modules in process, their calls into the runtime resolve against the symbols it exports
+if(UNIX AND NOT APPLE)
+    target_link_libraries(VIRELANG PRIVATE -Wl,--whole-archive virert -Wl,--no-whole-archive)
+    set_target_properties(VIRELANG PROPERTIES ENABLE_EXPORTS ON)
+endif()
@@ -0,0 +1,116 @@
+// Buffered output for the `put*` functions, printing a value does not make a syscall
+// Output to a terminal is flushed at every newline, everything else when the buffer fills up
+#include "virert.h"
+
+#include <charconv>
+#include <cstring>
+#include <mutex>
+#include <unistd.h>
+
+namespace
+{
+    // The longest line a `put*` function formats, -DBL_MAX in fixed notation is 317 characters
+    constexpr size_t max_line=330;
+
+    class OutputBuffer
+    {
+        static constexpr size_t capacity=1<<16;
+
+        char data[capacity];
+        size_t size=0;
+        bool line_buffered;
+        std::mutex mutex;
+
+        void writeOut()
+        {
+            size_t written=0;
+            while(written<size)
+            {
+                auto n=::write(STDOUT_FILENO, data+written, size-written);
+                if(n<=0) break;
+                written+=n;
+            }
+            size=0;
+        }
+    public:
+        OutputBuffer()
+        : line_buffered(isatty(STDOUT_FILENO)) {}
+        ~OutputBuffer()
+        {
+            flush();
+        }
+
+        // Appends a line, `format` writes at most `max_line` bytes and returns the end
+        template<typename F>
+        void writeLine(F format)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(capacity-size < max_line+1)
+            {
+                writeOut();
+            }
+
+            char* end=format(data+size);
+            *end++='\n';
+            size=end-data;
+
+            if(line_buffered)
+            {
+                writeOut();
+            }
+        }
+
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writeOut();
+        }
+    };
+
+    OutputBuffer stdout_buffer;
+
+    // Same output as printf's "%lf", the buffer holds every finite double in fixed notation
+    char* formatFixed(char* out, double n)
+    {
+        return std::to_chars(out, out+max_line, n, std::chars_format::fixed, 6).ptr;
+    }
+}
+
+extern "C"
+{
+    void puti(int32_t n)
+    {
+        stdout_buffer.writeLine([n](char* out) { return std::to_chars(out, out+max_line, n).ptr; });
+    }
+    void putl(int64_t n)
+    {
+        stdout_buffer.writeLine([n](char* out) { return std::to_chars(out, out+max_line, n).ptr; });
+    }
+    void putf(float n)
+    {
+        stdout_buffer.writeLine([n](char* out) { return formatFixed(out, n); });
+    }
+    void putd(double n)
+    {
+        stdout_buffer.writeLine([n](char* out) { return formatFixed(out, n); });
+    }
+    void putch(char c)
+    {
+        stdout_buffer.writeLine([c](char* out) { *out=c; return out+1; });
+    }
+    void putb(bool b)
+    {
+        stdout_buffer.writeLine([b](char* out)
+        {
+            const char* str=b ? "true" : "false";
+            size_t len=strlen(str);
+            memcpy(out, str, len);
+            return out+len;
+        });
+    }
+
+    void vire_flush()
+    {
+        stdout_buffer.flush();
+    }
+}
@@ -0,0 +1,58 @@
+// Math functions missing from libm, built with `-fno-math-errno` so `sqrt` becomes a single instruction
+// Codegen marks them as not accessing memory, calls are hoisted out of loops and deduplicated
+#include "virert.h"
+
+#include <cmath>
+
+extern "C"
+{
+    int32_t ipow(int32_t base, int32_t exp)
+    {
+        return (int32_t)lpow(base, exp);
+    }
+    int64_t lpow(int64_t base, int32_t exp)
+    {
+        if(exp<0)
+        {
+            return (base==1) ? 1 : ((base==-1) ? ((exp&1) ? -1 : 1) : 0);
+        }
+
+        // Results that do not fit wrap around, the unsigned products keep that defined
+        uint64_t result=1;
+        uint64_t factor=(uint64_t)base;
+        while(exp)
+        {
+            if(exp&1) result*=factor;
+            exp>>=1;
+            if(exp) factor*=factor;
+        }
+        return (int64_t)result;
+    }
+    int32_t isqrt(int32_t n)
+    {
+        if(n<=0) return 0;
+
+        // The double root is exact for every 32 bit integer, only the rounding needs fixing
+        auto r=(int64_t)std::sqrt((double)n);
+        while(r*r>n) --r;
+        while((r+1)*(r+1)<=n) ++r;
+        return (int32_t)r;
+    }
+
+    float rsqrtf(float n)
+    {
+        return 1.0f/std::sqrt(n);
+    }
+    double rsqrt(double n)
+    {
+        return 1.0/std::sqrt(n);
+    }
+    double lerp(double a, double b, double t)
+    {
+        return a+t*(b-a);
+    }
+    double clampd(double n, double lo, double hi)
+    {
+        return n<lo ? lo : (n>hi ? hi : n);
+    }
+}
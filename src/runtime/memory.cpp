@@ -0,0 +1,36 @@
+// Memory helpers, the loops are kept simple so that they are vectorized
+// Code generated by Vire lowers the `memset`, `memcpy` and `fill` builtins inline, these are for host code and externs
+#include "virert.h"
+
+#include <cstring>
+
+namespace
+{
+    template<typename T>
+    inline void fill(T* __restrict dst, int64_t count, T value)
+    {
+        for(int64_t i=0; i<count; ++i)
+        {
+            dst[i]=value;
+        }
+    }
+}
+
+extern "C"
+{
+    void vire_memset(void* dst, int32_t value, int64_t size)
+    {
+        memset(dst, value, size);
+    }
+    void vire_memcpy(void* dst, const void* src, int64_t size)
+    {
+        memcpy(dst, src, size);
+    }
+
+    void vire_fill_i8(int8_t* dst, int64_t count, int8_t value) { memset(dst, value, count); }
+    void vire_fill_i16(int16_t* dst, int64_t count, int16_t value) { fill(dst, count, value); }
+    void vire_fill_i32(int32_t* dst, int64_t count, int32_t value) { fill(dst, count, value); }
+    void vire_fill_i64(int64_t* dst, int64_t count, int64_t value) { fill(dst, count, value); }
+    void vire_fill_f32(float* dst, int64_t count, float value) { fill(dst, count, value); }
+    void vire_fill_f64(double* dst, int64_t count, double value) { fill(dst, count, value); }
+}
@@ -0,0 +1,226 @@
+// Runtime for `@parallel` loops, each loop is split into chunks that idle workers steal from each other
+// The number of threads can be set with the `VIRE_NUM_THREADS` environment variable
+#include "virert.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+typedef void (*RangeFunction)(int64_t begin, int64_t end, void* ctx);
+
+struct Range
+{
+    int64_t begin;
+    int64_t end;
+};
+
+// WorkQueue - The owner takes ranges from the back, idle workers steal from the front
+class WorkQueue
+{
+    std::mutex lock;
+    std::deque<Range> ranges;
+public:
+    void push(Range range)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ranges.push_back(range);
+    }
+    bool pop(Range& range)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if(ranges.empty())
+            return false;
+
+        range=ranges.back();
+        ranges.pop_back();
+        return true;
+    }
+    bool steal(Range& range)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if(ranges.empty())
+            return false;
+
+        range=ranges.front();
+        ranges.pop_front();
+        return true;
+    }
+};
+
+thread_local bool in_parallel_loop=false;
+
+// ThreadPool - Workers sleep until a loop is started, the calling thread works as queue 0
+class ThreadPool
+{
+    std::vector<std::thread> workers;
+    std::unique_ptr<WorkQueue[]> queues;
+    unsigned int queue_count;
+
+    std::mutex run_lock;
+    std::mutex job_lock;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+    uint64_t generation;
+    unsigned int active;
+    bool stopping;
+
+    RangeFunction func;
+    void* ctx;
+
+    bool next(unsigned int self, Range& range)
+    {
+        if(queues[self].pop(range))
+            return true;
+
+        for(unsigned int i=1; i<queue_count; ++i)
+        {
+            if(queues[(self+i)%queue_count].steal(range))
+                return true;
+        }
+
+        return false;
+    }
+    void work(unsigned int self)
+    {
+        in_parallel_loop=true;
+
+        Range range;
+        while(next(self, range))
+        {
+            func(range.begin, range.end, ctx);
+        }
+
+        in_parallel_loop=false;
+    }
+    void workerLoop(unsigned int self)
+    {
+        uint64_t seen=0;
+        while(true)
+        {
+            {
+                std::unique_lock<std::mutex> guard(job_lock);
+                job_ready.wait(guard, [&] { return stopping || generation!=seen; });
+                if(stopping)
+                    return;
+                seen=generation;
+            }
+
+            work(self);
+
+            {
+                std::lock_guard<std::mutex> guard(job_lock);
+                --active;
+            }
+            job_done.notify_one();
+        }
+    }
+public:
+    ThreadPool(unsigned int thread_count)
+    : queues(new WorkQueue[thread_count]), queue_count(thread_count), generation(0), active(0), stopping(false),
+    func(nullptr), ctx(nullptr)
+    {
+        for(unsigned int i=1; i<thread_count; ++i)
+        {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(job_lock);
+            stopping=true;
+        }
+        job_ready.notify_all();
+
+        for(auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    unsigned int getThreadCount() const { return queue_count; }
+
+    void run(int64_t begin, int64_t end, RangeFunction func, void* ctx)
+    {
+        std::lock_guard<std::mutex> serialize(run_lock);
+        this->func=func;
+        this->ctx=ctx;
+
+        // A few chunks per thread so that uneven iterations can be balanced by stealing
+        int64_t chunk_count=(int64_t)queue_count*4;
+        int64_t grain=std::max<int64_t>(1, (end-begin+chunk_count-1)/chunk_count);
+
+        unsigned int queue=0;
+        for(int64_t chunk=begin; chunk<end; chunk+=grain)
+        {
+            queues[queue].push({chunk, std::min(end, chunk+grain)});
+            queue=(queue+1)%queue_count;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(job_lock);
+            active=workers.size();
+            ++generation;
+        }
+        job_ready.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> guard(job_lock);
+        job_done.wait(guard, [&] { return active==0; });
+    }
+};
+
+unsigned int getThreadCount()
+{
+    if(const char* env=std::getenv("VIRE_NUM_THREADS"))
+    {
+        int count=std::atoi(env);
+        if(count>0)
+            return count;
+    }
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+ThreadPool& getThreadPool()
+{
+    static ThreadPool pool(getThreadCount());
+    return pool;
+}
+
+}
+
+extern "C"
+{
+    void vire_parallel_for(int64_t begin, int64_t end, RangeFunction func, void* ctx)
+    {
+        if(begin>=end)
+            return;
+
+        // Nested loops and tiny ranges run on the calling thread
+        if(in_parallel_loop || end-begin<2)
+        {
+            func(begin, end, ctx);
+            return;
+        }
+
+        auto& pool=getThreadPool();
+        if(pool.getThreadCount()<2)
+        {
+            func(begin, end, ctx);
+            return;
+        }
+
+        pool.run(begin, end, func, ctx);
+    }
+}
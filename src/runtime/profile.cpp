@@ -0,0 +1,163 @@
+// Runtime for code compiled with instrumentation, every function and loop is a site timed by enter/exit calls
+// At exit a flat profile and the call counts are written to stderr, or to the file named by `VIRE_PROFILE`
+#include "virert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct vire_profile_site
+{
+    std::string name;
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> total_ns{0}; // including the sites it entered, recursive calls are counted at every level
+    std::atomic<uint64_t> self_ns{0};
+
+    vire_profile_site(const char* name) : name(name) {}
+};
+
+namespace
+{
+
+uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Frame
+{
+    vire_profile_site* site;
+    uint64_t start;
+    uint64_t children_ns;
+};
+
+// Every thread times its own sites, a `@parallel` loop's body is timed on the worker that runs it
+thread_local std::vector<Frame> frames;
+
+void writeReport();
+
+// Profile - Owns the sites, the slots in the compiled code only point at them
+// The names are copied so that the report does not read a module that is gone, eg - one run by the JIT
+class Profile
+{
+    std::mutex lock;
+    std::deque<vire_profile_site> sites;
+public:
+    vire_profile_site* createSite(vire_profile_site** slot, const char* name)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        auto* site=__atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if(site)
+            return site;
+
+        if(sites.empty())
+            std::atexit(writeReport);
+
+        site=&sites.emplace_back(name);
+        __atomic_store_n(slot, site, __ATOMIC_RELEASE);
+        return site;
+    }
+
+    std::vector<vire_profile_site*> getSites()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        std::vector<vire_profile_site*> result;
+        for(auto& site : sites)
+            result.push_back(&site);
+        return result;
+    }
+};
+
+Profile& getProfile()
+{
+    static Profile profile;
+    return profile;
+}
+
+void closeFrame(Frame const& frame, uint64_t end)
+{
+    uint64_t elapsed=end-frame.start;
+    frame.site->total_ns.fetch_add(elapsed, std::memory_order_relaxed);
+    frame.site->self_ns.fetch_add(elapsed-std::min(elapsed, frame.children_ns), std::memory_order_relaxed);
+
+    if(!frames.empty())
+        frames.back().children_ns+=elapsed;
+}
+
+void writeReport()
+{
+    auto sites=getProfile().getSites();
+
+    FILE* out=stderr;
+    if(const char* path=std::getenv("VIRE_PROFILE"))
+    {
+        if(FILE* file=std::fopen(path, "w"))
+            out=file;
+    }
+
+    uint64_t self_sum=0;
+    for(auto* site : sites)
+        self_sum+=site->self_ns.load();
+
+    std::sort(sites.begin(), sites.end(), [](vire_profile_site* a, vire_profile_site* b) { return a->self_ns.load()>b->self_ns.load(); });
+    std::fprintf(out, "Flat profile, %.3f ms in %zu sites\n", self_sum/1e6, sites.size());
+    std::fprintf(out, "%8s %12s %12s %12s  %s\n", "% self", "self ms", "total ms", "calls", "name");
+    for(auto* site : sites)
+    {
+        uint64_t self=site->self_ns.load();
+        std::fprintf(out, "%8.2f %12.3f %12.3f %12llu  %s\n", self_sum ? 100.0*self/self_sum : 0.0, self/1e6, site->total_ns.load()/1e6,
+            (unsigned long long)site->calls.load(), site->name.c_str());
+    }
+
+    std::stable_sort(sites.begin(), sites.end(), [](vire_profile_site* a, vire_profile_site* b) { return a->calls.load()>b->calls.load(); });
+    std::fprintf(out, "\nCall counts\n");
+    std::fprintf(out, "%12s  %s\n", "calls", "name");
+    for(auto* site : sites)
+        std::fprintf(out, "%12llu  %s\n", (unsigned long long)site->calls.load(), site->name.c_str());
+
+    if(out!=stderr)
+        std::fclose(out);
+    else
+        std::fflush(out);
+}
+
+}
+
+extern "C"
+{
+    void vire_profile_enter(vire_profile_site** slot, const char* name)
+    {
+        auto* site=__atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if(!site)
+            site=getProfile().createSite(slot, name);
+
+        site->calls.fetch_add(1, std::memory_order_relaxed);
+        frames.push_back({site, now(), 0});
+    }
+    void vire_profile_exit(vire_profile_site** slot)
+    {
+        auto* site=__atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        auto it=std::find_if(frames.rbegin(), frames.rend(), [site](Frame const& frame) { return frame.site==site; });
+        if(!site || it==frames.rend())
+            return;
+
+        // The frames above the site's own are loops left by a `return`, they end with it
+        uint64_t end=now();
+        Frame frame;
+        do
+        {
+            frame=frames.back();
+            frames.pop_back();
+            closeFrame(frame, end);
+        }
+        while(frame.site!=site);
+    }
+}
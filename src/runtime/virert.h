@@ -0,0 +1,52 @@
+// libvirert - Runtime functions for compiled Vire programs
+// Declare the ones a program uses with `extern`, eg - `extern puti(n: int);`
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Printing, output is buffered and written out when the buffer fills up, on `vire_flush` and at exit
+void puti(int32_t n);
+void putl(int64_t n);
+void putf(float n);
+void putd(double n);
+void putch(char c);
+void putb(bool b);
+void vire_flush();
+
+// Memory
+void vire_memset(void* dst, int32_t value, int64_t size);
+void vire_memcpy(void* dst, const void* src, int64_t size);
+void vire_fill_i8(int8_t* dst, int64_t count, int8_t value);
+void vire_fill_i16(int16_t* dst, int64_t count, int16_t value);
+void vire_fill_i32(int32_t* dst, int64_t count, int32_t value);
+void vire_fill_i64(int64_t* dst, int64_t count, int64_t value);
+void vire_fill_f32(float* dst, int64_t count, float value);
+void vire_fill_f64(double* dst, int64_t count, double value);
+
+// Math
+int32_t ipow(int32_t base, int32_t exp);
+int64_t lpow(int64_t base, int32_t exp);
+int32_t isqrt(int32_t n);
+float rsqrtf(float n);
+double rsqrt(double n);
+double lerp(double a, double b, double t);
+double clampd(double n, double lo, double hi);
+
+// Parallel loops, called by the code generated for `@parallel for`
+void vire_parallel_for(int64_t begin, int64_t end, void(*body)(int64_t, int64_t, void*), void* ctx);
+
+// Profiling, called by code compiled with instrumentation, `site` points at a slot of the module that starts as null
+// A flat profile and the call counts are written to stderr at exit, or to the file named by `VIRE_PROFILE`
+typedef struct vire_profile_site vire_profile_site;
+void vire_profile_enter(vire_profile_site** site, const char* name);
+void vire_profile_exit(vire_profile_site** site);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,11 +2,28 @@
 
 #include <iostream>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include "llvm/IR/Verifier.h"
 
+#ifndef VIRE_USE_EMCC
+#include "vire/v_compiler/jit.hpp"
+#endif
+
 namespace vire
 {
+namespace
+{
+// Sends `std::cout` to another buffer for as long as it lives
+class CoutRedirect
+{
+    std::streambuf* previous;
+public:
+    CoutRedirect(std::streambuf* buffer) : previous(std::cout.rdbuf(buffer)) {}
+    ~CoutRedirect() { std::cout.rdbuf(previous); }
+};
+}
+
 void VApi::internal_setup()
 {
 
@@ -25,32 +42,75 @@ VApi::VApi()
 
 std::unique_ptr<VApi> VApi::loadFromFile(std::string input_file_path, std::string compilation_target)
 {
-    auto file=vire::proto::openFile(input_file_path);
-    std::string src=vire::proto::readFile(file, true);
+    // The file is memory mapped and never copied, the lexer and the analyzer work on the mapping
+    auto file=std::make_unique<proto::MappedFile>(input_file_path);
+    if(!file->isOpen())
+    {
+        std::cout << "File " << input_file_path << " doest not exist." << std::endl;
+    }
+    std::string_view src(file->getData(), file->getSize());
 
     auto ebuilder=std::make_unique<errors::ErrorBuilder>("This program");
-    auto lexer=std::make_unique<VLexer>(src, ebuilder.get());
+    ebuilder->setSource(src);
+    auto lexer=std::make_unique<VLexer>(src.data(), src.size(), ebuilder.get());
     auto parser=std::make_unique<VParser>(std::move(lexer));
     auto analyzer=std::make_unique<VAnalyzer>(ebuilder.get(), src);
     auto compiler=std::make_unique<VCompiler>(std::move(analyzer));
 
-    return std::make_unique<VApi>(std::move(parser), std::move(compiler), std::move(ebuilder), src, compilation_target);
+    auto api=std::make_unique<VApi>(std::move(parser), std::move(compiler), std::move(ebuilder), "", compilation_target);
+    api->source_file=std::move(file);
+    api->source_path=input_file_path;
+    return api;
 }
 std::unique_ptr<VApi> VApi::loadFromText(std::string input_code, std::string compilation_target)
 {
     auto ebuilder=std::make_unique<errors::ErrorBuilder>("This program");
     auto lexer=std::make_unique<VLexer>(input_code, ebuilder.get());
     auto parser=std::make_unique<VParser>(std::move(lexer));
-    auto analyzer=std::make_unique<VAnalyzer>(ebuilder.get(), input_code);
-    auto compiler=std::make_unique<VCompiler>(std::move(analyzer));
 
-    return std::make_unique<VApi>(std::move(parser), std::move(compiler), std::move(ebuilder), input_code, compilation_target); 
+    // The analyzer and the errors view the code kept by the api
+    auto api=std::make_unique<VApi>(std::move(parser), nullptr, std::move(ebuilder), std::move(input_code), compilation_target);
+    api->ebuilder->setSource(api->source_code);
+    api->compiler=std::make_unique<VCompiler>(std::make_unique<VAnalyzer>(api->ebuilder.get(), api->source_code));
+    return api;
 }
 
 void VApi::showErrors() const
 {
     getErrorBuilder()->showErrors();
 }
+std::string VApi::getDiagnosticsJSON() const
+{
+    if(!ebuilder)
+    {
+        return errors::ErrorBuilder().toJSON();
+    }
+    return ebuilder->toJSON();
+}
+void VApi::setMaxErrors(unsigned int max_errors)
+{
+    if(!ebuilder)
+    {
+        ebuilder=std::make_unique<errors::ErrorBuilder>("This program");
+    }
+    ebuilder->setMaxErrors(max_errors);
+}
+void VApi::setDebugInfo(DebugInfo kind)
+{
+    debug_info=kind;
+}
+void VApi::setDebugInfoStringOpt(std::string const& kind)
+{
+    setDebugInfo(str_to_debug_info[kind]);
+}
+void VApi::setPerfMap(bool enable)
+{
+    perf_map=enable;
+}
+void VApi::setInstrumentation(bool enable)
+{
+    instrument=enable;
+}
 errors::ErrorBuilder* const VApi::getErrorBuilder() const
 {
     return ebuilder.get();
@@ -59,22 +119,134 @@ VCompiler* const VApi::getCompiler() const
 {
     return compiler.get();
 }
+std::string_view VApi::getSourceView() const
+{
+    if(source_file)
+    {
+        return std::string_view(source_file->getData(), source_file->getSize());
+    }
+    return source_code;
+}
 
 bool VApi::parseSourceModule()
 {
-    ast=parser->ParseSourceModule();
+    // A cache of the same source skips lexing and parsing, otherwise the new parse is cached
+    if(ast_cache_path!="")
+    {
+        ast=serial::readASTCache(ast_cache_path, getSourceView());
+    }
+
+    if(!ast)
+    {
+        ast=parser->ParseSourceModule();
+
+        if(ast && ast_cache_path!="")
+        {
+            serial::writeASTCache(ast.get(), getSourceView(), ast_cache_path);
+        }
+    }
+
+    if(!ast)
+    {
+        return 0;
+    }
+    return loadImports();
+}
+bool VApi::reparseSourceModule(std::string const& new_code)
+{
+    source_code=new_code;
+    ast.reset();
+
+    // The analyzer and the struct types are not incremental, the whole module is verified again on a new analyzer
+    types::resetCustomTypes();
+    if(!ebuilder)
+    {
+        ebuilder=std::make_unique<errors::ErrorBuilder>("This program");
+    }
+    ebuilder->clearErrors();
+    ebuilder->setSource(source_code);
+    compiler=std::make_unique<VCompiler>(std::make_unique<VAnalyzer>(ebuilder.get(), source_code));
+
+    // New versions come as text, the lexer stops viewing the mapped file before it is unmapped
+    if(source_file)
+    {
+        if(parser)
+        {
+            parser->getLexer()->setCode(source_code);
+        }
+        source_file.reset();
+    }
+
+    if(!incremental)
+    {
+        incremental=std::make_unique<VIncrementalParser>(ebuilder.get());
+    }
+    ast=incremental->parse(source_code);
 
     if(!ast)
     {
         return 0;
     }
+    return loadImports();
+}
+// Imports are loaded from the interface files next to the source, the working directory for code loaded from text
+bool VApi::loadImports()
+{
+    auto dir=std::filesystem::path(source_path).parent_path();
+    std::unordered_map<std::string, bool> loaded;
+
+    for(auto const& name : ast->getImports())
+    {
+        if(loaded.count(name)>0)
+            continue;
+        loaded[name]=true;
+
+        auto interface_path=dir/(name+".vi");
+        auto module_path=dir/(name+".ve");
+        if(!std::filesystem::exists(interface_path))
+        {
+            std::cout << "Interface of module `" << name << "` not found, compile `" << module_path.string() << "` first" << std::endl;
+            return 0;
+        }
+
+        std::error_code ec;
+        if(std::filesystem::exists(module_path, ec) 
+            && std::filesystem::last_write_time(module_path, ec)>std::filesystem::last_write_time(interface_path, ec))
+        {
+            std::cout << "Warning: the interface of module `" << name << "` is older than its source" << std::endl;
+        }
+
+        auto imported=serial::readInterface(interface_path.string(), imported_type_sizes);
+        if(!imported)
+        {
+            return 0;
+        }
+        ast->addImportedModule(std::move(imported));
+    }
     return 1;
 }
 bool VApi::verifySourceModule()
 {
     bool success=compiler->getAnalyzer()->verifySourceModule(std::move(ast));
+
+    // The layout of an imported struct has to match the one its module was compiled with
+    for(auto const& [name, size] : imported_type_sizes)
+    {
+        auto it=types::custom_type_sizes.find(name);
+        if(it!=types::custom_type_sizes.end() && it->second!=size)
+        {
+            std::cout << "Struct `" << name << "` does not match the interface it was imported from" << std::endl;
+            success=false;
+        }
+    }
+
+    custom_type_sizes=types::custom_type_sizes;
     return success;
 }
+void VApi::restoreCustomTypes() const
+{
+    types::restoreCustomTypes(custom_type_sizes);
+}
 bool VApi::compileSourceModule(std::string const& output_file_path, bool write_to_file, Optimization opt_level, bool enable_lto)
 {
     std::string out_file_path;
@@ -93,6 +265,10 @@ bool VApi::compileSourceModule(std::string const& output_file_path, bool write_t
         out_file_path=output_file_path;
     }
 
+    compiler->setTarget(target);
+    compiler->setDebugInfo(debug_info);
+    compiler->setInstrumentation(instrument);
+    compiler->setDebugSource(source_path, getSourceView());
     compiler->compileModule();
 
     std::string errs;
@@ -120,6 +296,147 @@ bool VApi::compileSourceModuleStringOpt(std::string const& output_file_path, boo
 {
     return compileSourceModule(output_file_path, write_to_file, str_to_optimization[opt_level], enable_lto);
 }
+std::vector<BatchResult> VApi::compileBatch(std::vector<std::string> const& sources, std::string const& opt_level)
+{
+    auto opt=str_to_optimization.find(opt_level);
+    if(opt==str_to_optimization.end())
+    {
+        return std::vector<BatchResult>(sources.size(), BatchResult{false, {}, {"Unknown optimization level `"+opt_level+"`"}});
+    }
+
+    if(!ebuilder)
+    {
+        ebuilder=std::make_unique<errors::ErrorBuilder>("This program");
+    }
+    if(!parser)
+    {
+        parser=std::make_unique<VParser>(std::make_unique<VLexer>("", ebuilder.get()));
+    }
+    if(!compiler)
+    {
+        compiler=std::make_unique<VCompiler>(std::make_unique<VAnalyzer>(ebuilder.get(), ""));
+    }
+
+    std::vector<BatchResult> results;
+    results.reserve(sources.size());
+    for(auto const& src : sources)
+    {
+        BatchResult result{false, {}, {}};
+
+        // Parse and analyzer errors are written to stdout, they are kept as the diagnostics of this source
+        std::ostringstream messages;
+        {
+            CoutRedirect redirect(messages.rdbuf());
+
+            // The errors, the lexer and the analyzer view the source, they keep viewing it after the batch
+            batch_source=src;
+            types::resetCustomTypes();
+            ebuilder->clearErrors();
+            ebuilder->setSource(batch_source);
+            parser->getLexer()->setCode(batch_source);
+
+            auto mod=parser->ParseSourceModule();
+            if(mod)
+            {
+                compiler->resetAnalyzer(std::make_unique<VAnalyzer>(ebuilder.get(), batch_source));
+                if(compiler->getAnalyzer()->verifySourceModule(std::move(mod)))
+                {
+                    compiler->setTarget(target);
+                    compiler->setDebugInfo(debug_info);
+                    compiler->setInstrumentation(instrument);
+                    compiler->setDebugSource("", batch_source);
+                    compiler->compileModule();
+
+                    std::string errs;
+                    llvm::raw_string_ostream os(errs);
+                    if(!llvm::verifyModule(*compiler->getModule(), &os))
+                    {
+                        result.bytes=compiler->compileToString(target, opt->second, false);
+                        result.success=!result.bytes.empty();
+                    }
+                    else
+                    {
+                        os.flush();
+                        messages << errs;
+                    }
+                }
+            }
+        }
+
+        std::istringstream lines(messages.str());
+        for(std::string line; std::getline(lines, line);)
+        {
+            if(!line.empty())
+                result.diagnostics.push_back(line);
+        }
+        for(auto const& diagnostic : ebuilder->getDiagnostics())
+        {
+            result.diagnostics.push_back(errors::ErrorBuilder::toPlainText(diagnostic));
+        }
+        results.push_back(std::move(result));
+    }
+    ebuilder->clearErrors();
+    return results;
+}
+#ifndef VIRE_USE_EMCC
+int VApi::runSourceModule(Optimization opt_level)
+{
+    // The code runs here, so it is compiled for this machine whatever the target is
+    // JIT memory is not in the low 2GB a static executable's code is linked into
+    compiler->setPositionIndependent(true);
+    compiler->setTarget("sys");
+    compiler->setDebugInfo(debug_info);
+    compiler->setInstrumentation(instrument);
+    compiler->setDebugSource(source_path, getSourceView());
+    compiler->compileModule();
+    if(perf_map)
+    {
+        VJit::exposeLocalFunctions(*compiler->getModule());
+    }
+
+    std::vector<unsigned char> object;
+    if(!llvm::verifyModule(*compiler->getModule()))
+    {
+        object=compiler->compileToString("sys", opt_level);
+    }
+    compiler->setPositionIndependent(false);
+
+    VJit jit;
+    jit.setPerfMap(perf_map);
+    if(!jit.addObject(object, source_path.empty() ? "vire" : source_path))
+    {
+        return -1;
+    }
+    return jit.runMain();
+}
+int VApi::runSourceModuleStringOpt(std::string const& opt_level)
+{
+    return runSourceModule(str_to_optimization[opt_level]);
+}
+#endif
+bool VApi::writeInterface(std::string const& output_file_path)
+{
+    std::string out_file_path=output_file_path;
+    if(out_file_path=="")
+    {
+        if(source_path=="")
+        {
+            std::cout << "Interface file path required for code loaded from text" << std::endl;
+            return 0;
+        }
+        out_file_path=std::filesystem::path(source_path).replace_extension(".vi").string();
+    }
+
+    return serial::writeInterface(compiler->getAnalyzer()->getSourceModule(), out_file_path);
+}
+void VApi::setASTCachePath(std::string const& path)
+{
+    ast_cache_path=path;
+}
+void VApi::setSourcePath(std::string const& path)
+{
+    source_path=path;
+}
 std::vector<unsigned char> const& VApi::getByteOutput()
 {
     return byte_output;
@@ -133,6 +450,10 @@ std::string const& VApi::getCompiledLLVMIR()
 void VApi::setSourceCode(std::string new_code)
 {
     this->source_code=new_code;
+    if(ebuilder)
+    {
+        ebuilder->setSource(source_code);
+    }
 }
 void VApi::reset()
 {
@@ -146,15 +467,29 @@ using namespace emscripten;
 EMSCRIPTEN_BINDINGS(VAPI)
 {
     register_vector<unsigned char>("VireVectorUC");
+    register_vector<std::string>("VireVectorString");
+
+    value_object<BatchResult>("VireBatchResult")
+    .field("success", &BatchResult::success)
+    .field("bytes", &BatchResult::bytes)
+    .field("diagnostics", &BatchResult::diagnostics)
+    ;
+    register_vector<BatchResult>("VireVectorBatchResult");
 
     class_<VApi>("VireAPI")
     .constructor<>()
     .function("ParseSourceModule", &VApi::parseSourceModule)
+    .function("ReparseSourceModule", &VApi::reparseSourceModule)
     .function("VerifySourceModule", &VApi::verifySourceModule)
     .function("CompileSourceModule", &VApi::compileSourceModuleStringOpt)
+    .function("CompileBatch", &VApi::compileBatch)
     .function("getByteOutput", &VApi::getByteOutput)
     .function("getCompiledLLVMIR", &VApi::getCompiledLLVMIR)
     .function("showErrors", &VApi::showErrors)
+    .function("getDiagnosticsJSON", &VApi::getDiagnosticsJSON)
+    .function("setMaxErrors", &VApi::setMaxErrors)
+    .function("SetDebugInfo", &VApi::setDebugInfoStringOpt)
+    .function("SetInstrumentation", &VApi::setInstrumentation)
     .function("setSourceCode", &VApi::setSourceCode)
     .function("reset", &VApi::reset)
     .class_function("loadFromText", &VApi::loadFromText)
@@ -2,9 +2,12 @@
 
 #include <filesystem>
 #include <memory>
+#include <string_view>
+#include <unordered_map>
 
 #include "vire/proto/include.hpp"
 #include "vire/v_compiler/include.hpp"
+#include "vire/serial/include.hpp"
 
 #ifdef VIRE_USE_EMCC
 #include <emscripten/emscripten.h>
@@ -14,19 +17,39 @@
 namespace vire
 {
 
+// BatchResult - The output of one source compiled by `VApi::compileBatch`
+struct BatchResult
+{
+    bool success;
+    std::vector<unsigned char> bytes;
+    std::vector<std::string> diagnostics;
+};
+
 class VApi
 {
     std::unique_ptr<VParser> parser;
     std::unique_ptr<VCompiler> compiler;
     std::unique_ptr<ModuleAST> ast;
     std::unique_ptr<errors::ErrorBuilder> ebuilder;
+    std::unique_ptr<VIncrementalParser> incremental;
 
     std::string source_code;
+    std::string batch_source; // the source `compileBatch` compiled last, copied since the parser and the analyzer view it
+    std::unique_ptr<proto::MappedFile> source_file; // the source of `loadFromFile`, lexed and analyzed in place
+    std::string source_path;
+    std::string ast_cache_path;
     std::string target;
+    DebugInfo debug_info=DebugInfo::None;
+    bool perf_map=false;
+    bool instrument=false;
 
     std::vector<unsigned char> byte_output;
+    std::unordered_map<std::string, std::uint64_t> imported_type_sizes;
+    std::unordered_map<std::string, std::uint64_t> custom_type_sizes; // the structs of the source last verified, see `restoreCustomTypes`
 private:
     void internal_setup();
+    bool loadImports();
+    std::string_view getSourceView() const;
 
 public:
     VApi(std::unique_ptr<VParser> parser, std::unique_ptr<VCompiler> compiler, 
@@ -37,14 +60,43 @@ public:
     static std::unique_ptr<VApi> loadFromText(std::string input_code, std::string compilation_target="sys");
 
     bool parseSourceModule();
+    // Parses a new version of the source, only the top-level declarations that changed are parsed again
+    bool reparseSourceModule(std::string const& new_code);
     bool verifySourceModule();
+    // The struct types are global and belong to the source verified last, this makes the ones of this source current again
+    // Needed before the module of this api is used after another source was verified, eg - by the language server
+    void restoreCustomTypes() const;
     bool compileSourceModule(std::string const& output_file_name="", bool write_to_file=true, Optimization opt_level=Optimization::O0, bool enable_lto=false);
     bool compileSourceModuleStringOpt(std::string const& output_file_name="", bool write_to_file=true, std::string const& opt_level="O0", bool enable_lto=false);
+    bool writeInterface(std::string const& output_file_path="");
+    // Compiles every source to an object with the same parser, context, target machine and pass pipeline
+    std::vector<BatchResult> compileBatch(std::vector<std::string> const& sources, std::string const& opt_level="O0");
+#ifndef VIRE_USE_EMCC
+    // Compiles the module for this machine and runs its `main` in this process, returns what `main` returns or -1
+    int runSourceModule(Optimization opt_level=Optimization::O0);
+    int runSourceModuleStringOpt(std::string const& opt_level="O0");
+#endif
+
+    void setASTCachePath(std::string const& path);
+    // Imports are looked up next to this path
+    void setSourcePath(std::string const& path);
 
     void setSourceCode(std::string new_code);
     void reset();
 
     void showErrors() const;
+    // The diagnostics of the last parse as JSON, see `errors::ErrorBuilder::toJSON`
+    std::string getDiagnosticsJSON() const;
+    // Parsing stops after this many errors, 0 for no limit
+    void setMaxErrors(unsigned int max_errors);
+    // DWARF for the next compilations, by default none is emitted
+    void setDebugInfo(DebugInfo kind);
+    // "g0", "gline-tables-only" or "g"
+    void setDebugInfoStringOpt(std::string const& kind);
+    // Names the functions of `runSourceModule` for `perf` in `/tmp/perf-<pid>.map`
+    void setPerfMap(bool enable);
+    // Profiles every function and loop, the report is written at exit by libvirert, see `VCompiler::setInstrumentation`
+    void setInstrumentation(bool enable);
     errors::ErrorBuilder* const getErrorBuilder() const;
     VCompiler* const getCompiler() const;
 
@@ -17,7 +17,7 @@ namespace vire
 class ExprAST
 {
 protected:
-    std::unique_ptr<types::Base> type;
+    types::Base* type; // owned by `types::type_table`
     std::unique_ptr<VToken> token;
 public:
     int asttype;
@@ -25,20 +25,20 @@ public:
     : asttype(asttype), token(std::move(token)), type(types::construct(type))
     {}
 
-    ExprAST(std::unique_ptr<types::Base> type, int asttype, std::unique_ptr<VToken> token=nullptr)
-    : asttype(asttype), token(std::move(token)), type(std::move(type))
+    ExprAST(types::Base* type, int asttype, std::unique_ptr<VToken> token=nullptr)
+    : asttype(asttype), token(std::move(token)), type(type)
     {}
 
     virtual ~ExprAST() = default;
 
     virtual std::unique_ptr<ExprAST> copyAST() const
     {
-        return std::make_unique<ExprAST>(types::copyType(type.get()), asttype, VToken::construct(token.get()));
+        return std::make_unique<ExprAST>(type, asttype, VToken::construct(token.get()));
     }
 
     virtual types::Base* getType() const 
     {
-        return type.get(); 
+        return type; 
     }
 
     virtual bool refreshType()
@@ -60,32 +60,28 @@ public:
 
         return false;
     }
-    virtual void setType(std::unique_ptr<types::Base> t)
+    virtual void setType(types::Base* t)
     {
-        bool refreshed=refreshType(t.get());
+        bool refreshed=refreshType(t);
         if(!refreshed)
         {
-            type=std::move(t);
+            type=t;
         }
     }
     virtual void setType(std::string const& newtype) 
     {
         setType(types::construct(newtype)); 
     }
-    virtual void setType(types::Base* t)
-    {
-        setType(std::unique_ptr<types::Base>(t));
-    }
 
-    virtual const std::size_t& getLine()    const 
+    const std::size_t& getLine()    const 
     {
         return token->line;
     }
-    virtual const std::size_t& getCharpos() const 
+    const std::size_t& getCharpos() const 
     {
         return token->charpos;
     } 
-    virtual void setToken(std::unique_ptr<VToken> token) 
+    void setToken(std::unique_ptr<VToken> token) 
     {
         this->token.reset(); this->token=std::move(token);
     }
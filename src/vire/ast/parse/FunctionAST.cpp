@@ -14,12 +14,85 @@ namespace vire
 
 class ReturnExprAST;
 
+// FunctionAttribute - Flags given with `@attr` after a prototype, eg - `func f() returns int @pure`
+enum FunctionAttribute : unsigned int
+{
+    fattr_none=0,
+
+    fattr_inline=1<<0,
+    fattr_noinline=1<<1,
+
+    fattr_pure=1<<2,
+    fattr_readonly=1<<3,
+
+    fattr_hot=1<<4,
+    fattr_cold=1<<5,
+};
+
+// BuiltinFunction - Functions lowered directly by the compiler, they are callable without an `extern`
+enum BuiltinFunction : unsigned int
+{
+    builtin_none=0,
+
+    builtin_memset,
+    builtin_memcpy,
+    builtin_fill,
+
+    builtin_sqrt,
+    builtin_fma,
+    builtin_abs,
+    builtin_min,
+    builtin_max,
+    builtin_floor,
+    builtin_popcount,
+    builtin_clz,
+};
+
+inline BuiltinFunction getBuiltinFunction(std::string const& name)
+{
+    static const std::map<std::string, BuiltinFunction> builtins=
+    {
+        {"memset", builtin_memset},
+        {"memcpy", builtin_memcpy},
+        {"fill", builtin_fill},
+
+        {"sqrt", builtin_sqrt},
+        {"fma", builtin_fma},
+        {"abs", builtin_abs},
+        {"min", builtin_min},
+        {"max", builtin_max},
+        {"floor", builtin_floor},
+        {"popcount", builtin_popcount},
+        {"clz", builtin_clz},
+    };
+
+    auto it=builtins.find(name);
+    return it==builtins.end() ? builtin_none : it->second;
+}
+// Memory builtins write to their first argument, the others are pure math lowered to intrinsics
+inline bool isMemoryBuiltin(BuiltinFunction builtin)
+{
+    return builtin==builtin_memset || builtin==builtin_memcpy || builtin==builtin_fill;
+}
+inline unsigned int getBuiltinArgCount(BuiltinFunction builtin)
+{
+    switch(builtin)
+    {
+        case builtin_fma: return 3;
+        case builtin_memset: case builtin_memcpy: case builtin_fill:
+        case builtin_min: case builtin_max: return 2;
+        default: return 1;
+    }
+}
+
 // CallExprAST - Class for function calls, eg - `print()`
 class CallExprAST : public ExprAST
 {
     proto::IName callee;
     std::unique_ptr<VToken> callee_token;
     std::vector<std::unique_ptr<ExprAST>> args;
+    BuiltinFunction builtin=builtin_none;
+    types::Base* builtin_type=nullptr;
 public:
     CallExprAST(std::unique_ptr<VToken> callee_token, std::vector<std::unique_ptr<ExprAST>> args)
     : callee(callee_token->value), callee_token(std::move(callee_token)), args(std::move(args)), ExprAST("void",ast_call)
@@ -54,27 +127,38 @@ public:
     {
         args=std::move(_args);
     }
+
+    BuiltinFunction getBuiltin() const
+    {
+        return builtin;
+    }
+    // The result type of a builtin is kept apart from `type`, which is replaced when the call gets casted
+    types::Base* getBuiltinType() const
+    {
+        return builtin_type;
+    }
+    void setBuiltin(BuiltinFunction _builtin, types::Base* type)
+    {
+        builtin=_builtin;
+        builtin_type=type;
+    }
 };
 
 // FunctionBaseAST - Base Class for the functions
 class FunctionBaseAST
 {
 protected:
-    std::unique_ptr<types::Base> return_type;
+    types::Base* return_type;
 public:
     FunctionBaseAST(std::string return_name)
     :   return_type(types::construct(return_name))
     {}
     FunctionBaseAST(types::Base* type)
-    :   return_type(types::copyType(type))
-    {}
-    FunctionBaseAST(std::unique_ptr<types::Base> type)
-    : return_type(std::move(type))
+    :   return_type(type)
     {}
     
-    types::Base* getReturnType() const { return return_type.get(); }
-    void setReturnType(std::unique_ptr<types::Base> t) { this->return_type=std::move(t); }
-    void setReturnType(types::Base* t) { this->return_type=types::copyType(t); }
+    types::Base* getReturnType() const { return return_type; }
+    void setReturnType(types::Base* t) { this->return_type=t; }
 
     virtual proto::IName const& getIName() const = 0;
 
@@ -96,6 +180,9 @@ public:
 
     virtual void isConstructor(bool val) {}
     virtual bool isConstructor() const { return false; }
+
+    virtual unsigned int getAttributes() const { return fattr_none; }
+    bool hasAttribute(FunctionAttribute attr) const { return (getAttributes() & attr) != 0; }
     //virtual bool isVariableDefined(std::string const& name) const = 0;
     //virtual VariableDefAST* const getVariable(const std::string& name) const = 0;
 
@@ -110,12 +197,13 @@ class PrototypeAST : public FunctionBaseAST
     std::vector<std::unique_ptr<VariableDefAST>> args;
     bool is_constructor;
     bool requires_selfref;
+    unsigned int attributes;
 public:
     int asttype;
 
-    PrototypeAST(std::unique_ptr<VToken> name, std::vector<std::unique_ptr<VariableDefAST>> args, std::unique_ptr<types::Base> return_type, bool requires_selfref=false, bool is_constructor=false)
-    : FunctionBaseAST(std::move(return_type)), args(std::move(args)), asttype(ast_proto), requires_selfref(requires_selfref), is_constructor(is_constructor),
-    name(name->value), name_token(std::move(name))
+    PrototypeAST(std::unique_ptr<VToken> name, std::vector<std::unique_ptr<VariableDefAST>> args, types::Base* return_type, bool requires_selfref=false, bool is_constructor=false)
+    : FunctionBaseAST(return_type), args(std::move(args)), asttype(ast_proto), requires_selfref(requires_selfref), is_constructor(is_constructor),
+    attributes(fattr_none), name(name->value), name_token(std::move(name))
     {}
 
     proto::IName const& getIName()    const { return name; }
@@ -138,6 +226,9 @@ public:
     void isConstructor(bool val) { is_constructor=val; }
     bool isConstructor() const { return is_constructor; }
 
+    unsigned int getAttributes() const { return attributes; }
+    void setAttributes(unsigned int attrs) { attributes=attrs; }
+
     std::vector<std::unique_ptr<VariableDefAST>> const& getArgs() const {return args;}
     std::vector<std::unique_ptr<VariableDefAST>>& getModifyableArgs() {return args;}
 };
@@ -171,6 +262,8 @@ public:
 
     void doesRequireSelfRef(bool val) { }
     bool doesRequireSelfRef() const { return false; }
+
+    unsigned int getAttributes() const { return proto->getAttributes(); }
 };
 
 // FunctionAST - Class for functions which can be called by the user
@@ -179,7 +272,7 @@ class FunctionAST : public FunctionBaseAST
     std::unique_ptr<PrototypeAST> proto;
     std::vector<std::unique_ptr<ExprAST>> statements;
     std::vector<ReturnExprAST*> return_stms;
-    std::unordered_map<std::string, VariableDefAST*> locals;
+    std::map<std::string, VariableDefAST*> locals; // ordered, the allocas of the locals are created in this order
     std::unordered_map<std::string, unsigned int> arg_indxs;
     bool requires_selfref;
     bool is_constructor;
@@ -207,7 +300,7 @@ public:
     VToken* const getNameToken()      const { return proto->getNameToken(); }
     std::unique_ptr<VToken> moveNameToken() { return proto->moveNameToken(); }
 
-    void setReturnType(std::unique_ptr<types::Base> type) { proto->setReturnType(types::copyType(type.get())); this->return_type=std::move(type); }
+    void setReturnType(types::Base* type) { proto->setReturnType(type); this->return_type=type; }
 
     // Block-based Functions
     void insertStatement(std::unique_ptr<ExprAST> statement) 
@@ -216,7 +309,7 @@ public:
     // Variable-based Functions
     bool isVariableDefined(std::string const& name)            const { return locals.count(name)>0; }
     VariableDefAST* const getVariable(std::string const& name) const { return locals.at(name); }
-    std::unordered_map<std::string, VariableDefAST*> const& getLocals() const { return locals; }
+    std::map<std::string, VariableDefAST*> const& getLocals() const { return locals; }
 
     // Return statement functions
     std::vector<ReturnExprAST*> const& getReturnStatements() const { return return_stms; }
@@ -227,7 +320,6 @@ public:
     {
         if(are_args)
             arg_indxs.reserve(arg_indxs.size()+vars.size());
-        locals.reserve(locals.size()+vars.size());
 
         for(auto const& var : vars)
             addVariable(var);
@@ -239,6 +331,8 @@ public:
 
     void isConstructor(bool val) { proto->isConstructor(val); }
     bool isConstructor() const { return proto->isConstructor(); }
+
+    unsigned int getAttributes() const { return proto->getAttributes(); }
 };
 
 class ReturnExprAST : public ExprAST
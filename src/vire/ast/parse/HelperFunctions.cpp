@@ -3,8 +3,16 @@
 #include "ASTType.hpp"
 #include "ExprAST.cpp"
 #include "FunctionAST.cpp"
+#include "LiteralAST.cpp"
+#include "OpAST.cpp"
+#include "VariableAST.cpp"
+#include "LoopAST.cpp"
+#include "ControlFlow.cpp"
+#include "Memory.cpp"
+#include "Identifier.cpp"
 
 #include <memory>
+#include <functional>
 
 namespace vire
 {
@@ -49,4 +57,105 @@ std::unique_ptr<T> cast_static(std::unique_ptr<FunctionBaseAST> expr)
     return std::move(newAST);
 }
 
-}
\ No newline at end of file
+}
+
+namespace vire
+{
+
+// Calls `fn` on every direct child expression of `expr`
+// The member names of a type access are not expressions, so only the parent (and method calls) are visited
+inline void forEachChild(ExprAST* const expr, std::function<void(ExprAST*)> const& fn)
+{
+    auto visit=[&fn](ExprAST* const e) { if(e) fn(e); };
+    auto visit_block=[&visit](std::vector<std::unique_ptr<ExprAST>> const& block)
+    {
+        for(auto const& e : block) visit(e.get());
+    };
+
+    switch(expr->asttype)
+    {
+        case ast_vardef: visit(((VariableDefAST*)expr)->getValue()); break;
+        case ast_varassign:
+        {
+            auto* assign=(VariableAssignAST*)expr;
+            visit(assign->getLHS());
+            visit(assign->getRHS());
+            break;
+        }
+        case ast_array_access:
+        {
+            auto* access=(VariableArrayAccessAST*)expr;
+            visit(access->getExpr());
+            visit_block(access->getIndices());
+            break;
+        }
+        case ast_type_access:
+        {
+            auto* access=(TypeAccessAST*)expr;
+            visit(access->getParent());
+            if(access->getChild()->asttype==ast_call)
+                visit(access->getChild());
+            break;
+        }
+        case ast_cast: visit(((CastExprAST*)expr)->getExpr()); break;
+        case ast_unop: visit(((UnaryExprAST*)expr)->getExpr()); break;
+        case ast_binop:
+        {
+            auto* binop=(BinaryExprAST*)expr;
+            visit(binop->getLHS());
+            visit(binop->getRHS());
+            break;
+        }
+        case ast_incrdecr: visit(((IncrementDecrementAST*)expr)->getExpr()); break;
+        case ast_array: visit_block(((ArrayExprAST*)expr)->getElements()); break;
+        case ast_call: visit_block(((CallExprAST*)expr)->getArgs()); break;
+        case ast_return: visit(((ReturnExprAST*)expr)->getValue()); break;
+        case ast_for:
+        {
+            auto* for_=(ForExprAST*)expr;
+            visit(for_->getInit());
+            visit(for_->getCond());
+            visit(for_->getIncr());
+            visit_block(for_->getBody());
+            visit_block(for_->getCaptures());
+            break;
+        }
+        case ast_while:
+        {
+            auto* while_=(WhileExprAST*)expr;
+            visit(while_->getCond());
+            visit_block(while_->getBody());
+            break;
+        }
+        case ast_break: visit(((BreakExprAST*)expr)->getAfterBreak()); break;
+        case ast_continue: visit(((ContinueExprAST*)expr)->getAfterCont()); break;
+        case ast_if:
+        {
+            auto* if_then=(IfThenExpr*)expr;
+            visit(if_then->getCondition());
+            visit_block(if_then->getThenBlock());
+            break;
+        }
+        case ast_ifelse:
+        {
+            auto* if_=(IfExprAST*)expr;
+            visit(if_->getIfThen());
+            for(auto const& elif : if_->getElifLadder())
+                visit(elif.get());
+            break;
+        }
+        case ast_unsafe: visit_block(((UnsafeExprAST*)expr)->getBody()); break;
+        case ast_reference: visit(((ReferenceExprAST*)expr)->getVariable()); break;
+
+        default: break;
+    }
+}
+
+// Calls `fn` on `expr` and on all of its descendants, parents are visited before their children
+inline void forEachExpr(ExprAST* const expr, std::function<void(ExprAST*)> const& fn)
+{
+    fn(expr);
+    forEachChild(expr, [&fn](ExprAST* child) { forEachExpr(child, fn); });
+}
+
+}
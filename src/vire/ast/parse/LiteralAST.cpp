@@ -91,8 +91,7 @@ public:
     ArrayExprAST(std::vector<std::unique_ptr<ExprAST>> elements)
     :   elements(std::move(elements)), ExprAST("arr", ast_array) 
     {
-        auto t=std::make_unique<types::Array>(types::construct("void"), this->elements.size());
-        setType(std::move(t));
+        setType(types::getArray(types::construct("void"), this->elements.size()));
     }
 
     std::vector<std::unique_ptr<ExprAST>> const& getElements() const {return elements;}
@@ -4,11 +4,34 @@
 #include "ExprAST.cpp"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace vire
 {
 
+// Per-loop optimization hints, given as `@unroll(4) @vectorize(8) for(...)`
+// A value of 0 means the hint was not given
+struct LoopHints
+{
+    unsigned int unroll_count=0;
+    unsigned int vectorize_width=0;
+    unsigned int interleave_count=0;
+    bool unroll_full=false;
+    bool unroll_disable=false;
+    bool vectorize_disable=false;
+
+    // `@parallel` - the iterations are independent and are run on a thread pool
+    bool parallel=false;
+
+    // Returns true if there are no hints that are emitted as loop metadata
+    bool empty() const
+    {
+        return !unroll_count && !vectorize_width && !interleave_count 
+        && !unroll_full && !unroll_disable && !vectorize_disable;
+    }
+};
+
 class ForExprAST : public ExprAST
 {
     std::unique_ptr<ExprAST> initExpr;
@@ -16,6 +39,12 @@ class ForExprAST : public ExprAST
     std::unique_ptr<ExprAST> incrExpr;
 
     std::vector<std::unique_ptr<ExprAST>> body;
+    LoopHints hints;
+
+    // A `@parallel` loop's body is outlined into a function by the analyzer,
+    // the captured variables are passed to it after the induction variable
+    std::string outlined_name;
+    std::vector<std::unique_ptr<ExprAST>> captures;
 public:
     ForExprAST(std::unique_ptr<ExprAST> init, std::unique_ptr<ExprAST> cond, std::unique_ptr<ExprAST> incr,
     std::vector<std::unique_ptr<ExprAST>> body) :
@@ -33,12 +62,24 @@ public:
 
     std::vector<std::unique_ptr<ExprAST>> const& getBody() { return body; }
     std::vector<std::unique_ptr<ExprAST>> moveBody() { return std::move(body); }
+
+    LoopHints const& getHints() const { return hints; }
+    void setHints(LoopHints hints) { this->hints=hints; }
+
+    bool isParallel() const { return hints.parallel; }
+
+    std::string const& getOutlinedName() const { return outlined_name; }
+    void setOutlinedName(std::string const& name) { outlined_name=name; }
+
+    std::vector<std::unique_ptr<ExprAST>> const& getCaptures() const { return captures; }
+    void addCapture(std::unique_ptr<ExprAST> capture) { captures.push_back(std::move(capture)); }
 };
 
 class WhileExprAST : public ExprAST
 {
     std::unique_ptr<ExprAST> condExpr;
     std::vector<std::unique_ptr<ExprAST>> body;
+    LoopHints hints;
 public:
     WhileExprAST(std::unique_ptr<ExprAST> cond, std::vector<std::unique_ptr<ExprAST>> Stms) 
     : condExpr(std::move(cond)), body(std::move(Stms)), ExprAST("void",ast_while) 
@@ -48,6 +89,9 @@ public:
     
     std::vector<std::unique_ptr<ExprAST>> const& getBody() { return body; }
     std::vector<std::unique_ptr<ExprAST>> moveBody() {return std::move(body);}
+
+    LoopHints const& getHints() const { return hints; }
+    void setHints(LoopHints hints) { this->hints=hints; }
 };
 
 class BreakExprAST : public ExprAST
@@ -27,6 +27,7 @@ public:
     {}
 
     ExprAST* const getVariable() { return var.get(); }
+    std::unique_ptr<ExprAST> moveVariable() { return std::move(var); }
 };
 
 }
\ No newline at end of file
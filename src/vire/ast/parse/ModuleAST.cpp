@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace vire
 {
@@ -21,6 +22,7 @@ class ModuleAST
     std::vector<std::unique_ptr<FunctionBaseAST>> Functions;
     std::vector<std::unique_ptr<ClassAST>> Classes;
     std::vector<std::unique_ptr<ExprAST>> UnionStructs;
+    std::vector<std::string> Imports;
 public:
     ModuleAST(std::vector<std::unique_ptr<ExprAST>> PreExecutionStatements,
             std::vector<std::unique_ptr<FunctionBaseAST>> Functions,
@@ -49,6 +51,9 @@ public:
     std::vector<FunctionAST*> const& getConstructors() const {
         return Constructors;
     }
+    std::vector<std::string> const& getImports() const {
+        return Imports;
+    }
 
     std::vector<std::unique_ptr<ExprAST>> movePreExecutionStatements() {
         return std::move(PreExecutionStatements);
@@ -78,6 +83,20 @@ public:
         UnionStructs.push_back(std::move(union_struct));
     }
 
+    void addImport(std::string const& name)
+    {
+        Imports.push_back(name);
+    }
+    // The declarations of an imported module go in front, so they are verified before the code using them
+    void addImportedModule(std::unique_ptr<ModuleAST> imported)
+    {
+        auto funcs=imported->moveFunctions();
+        Functions.insert(Functions.begin(), std::make_move_iterator(funcs.begin()), std::make_move_iterator(funcs.end()));
+
+        auto union_structs=imported->moveUnionStructs();
+        UnionStructs.insert(UnionStructs.begin(), std::make_move_iterator(union_structs.begin()), std::make_move_iterator(union_structs.end()));
+    }
+
     void addPreExecutionStatements(std::vector<std::unique_ptr<ExprAST>> stms){
         this->PreExecutionStatements.reserve(this->PreExecutionStatements.size() + stms.size());
         this->PreExecutionStatements.insert(this->PreExecutionStatements.end(), std::make_move_iterator(stms.begin()), std::make_move_iterator(stms.end()));
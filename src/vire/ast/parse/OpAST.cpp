@@ -56,7 +56,7 @@ public:
             case tok_div:   return nullptr;
             case tok_mod:   return nullptr;
         default:
-            return type.get();
+            return type;
         }
     }
 };
@@ -7,6 +7,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <algorithm>
 
 namespace vire
 {
@@ -20,6 +21,7 @@ class TypeAST : public ExprAST
 {
     INameExprMap members;
     INameIntMap members_indx;
+    std::vector<proto::IName> members_order;
     proto::IName name;
     std::unique_ptr<VToken> name_token;
 public:
@@ -27,10 +29,32 @@ public:
     : members(std::move(members)), members_indx(INameIntMap()), name(name->value), ExprAST("void", asttype)
     {
         name_token=std::move(name);
-        int i=this->members.size()-1;
+
+        // Sorted until the declaration order is set, the order of the map depends on its hashing
+        std::vector<proto::IName> order;
         for(auto& [iname, ptr] : this->members)
         {
-            this->members_indx[iname]=i--;
+            order.push_back(iname);
+        }
+        std::sort(order.begin(), order.end(), [](proto::IName const& a, proto::IName const& b) { return a.name<b.name; });
+        setMembersOrder(std::move(order));
+    }
+
+    // The order of `getMembersValues`, the layout index of a member is its position in it
+    // Set to the declaration order by whoever creates the type, so the layout only depends on the source
+    std::vector<proto::IName> const& getMembersOrder() const
+    {
+        return members_order;
+    }
+    void setMembersOrder(std::vector<proto::IName> order)
+    {
+        members_order=std::move(order);
+        members_indx.clear();
+
+        int i=0;
+        for(auto const& iname : members_order)
+        {
+            members_indx[iname]=i++;
         }
     }
 
@@ -42,6 +66,10 @@ public:
     {
         return name;
     }
+    VToken* const getNameToken() const
+    {
+        return name_token.get();
+    }
     virtual void setName(std::string new_name)
     {
         name.setName(new_name);
@@ -56,9 +84,9 @@ public:
         std::vector<ExprAST*> values;
         values.reserve(members.size());
 
-        for(auto& [str,ptr]:members)
+        for(auto const& iname : members_order)
         {
-            values.push_back(ptr.get());
+            values.push_back(members.at(iname).get());
         }
 
         return values;
@@ -99,6 +127,7 @@ public:
 class StructExprAST : public TypeAST
 {
     std::unique_ptr<FunctionAST> constructor;
+    bool is_imported=false;
 public:
     StructExprAST(INameExprMap members, std::unique_ptr<FunctionAST> constructor, std::unique_ptr<VToken> name)
     : TypeAST(std::move(members), std::move(name), ast_struct), constructor(std::move(constructor))
@@ -111,6 +140,10 @@ public:
 
     FunctionAST* const getConstructor() const { return constructor.get(); }
     void setConstructor(std::unique_ptr<FunctionAST> new_constructor) { constructor=std::move(new_constructor); }
+
+    // Loaded from the interface of another module, its constructor is defined there
+    void isImported(bool value) { is_imported=value; }
+    bool isImported() const { return is_imported; }
 };
 
 }
\ No newline at end of file
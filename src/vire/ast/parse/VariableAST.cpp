@@ -83,11 +83,13 @@ class VariableDefAST : public ExprAST
     bool use_value_type;
     bool is_returned;
     bool is_argument;
+    bool is_reference;
+    bool is_noalias;
 public:
-    VariableDefAST(std::unique_ptr<VToken> name, std::unique_ptr<types::Base> type, std::unique_ptr<ExprAST> value,
+    VariableDefAST(std::unique_ptr<VToken> name, types::Base* type, std::unique_ptr<ExprAST> value,
     bool is_const=false, bool is_let=false)
-    : name(name->value), value(std::move(value)), ExprAST(std::move(type),ast_vardef), 
-    is_const(is_const),is_let(is_let), use_value_type(false), is_returned(false), is_argument(false)
+    : name(name->value), value(std::move(value)), ExprAST(type,ast_vardef), 
+    is_const(is_const),is_let(is_let), use_value_type(false), is_returned(false), is_argument(false), is_reference(false), is_noalias(false)
     {
         setToken(std::move(name));
     }
@@ -108,16 +110,12 @@ public:
             return value->getType();
         }
 
-        return type.get();
+        return type;
     }
-    void setType(std::unique_ptr<types::Base> type) 
+    void setType(types::Base* type) 
     {
         this->type=nullptr;
-        value->setType(std::move(type));
-    }
-    void setType(types::Base* t)
-    {
-        value->setType(t);
+        value->setType(type);
     }
 
     ExprAST* const getValue() const {return value.get();}
@@ -131,16 +129,22 @@ public:
 
     void isArgument(bool value) { is_argument=value; }
     bool isArgument() { return is_argument; }
+
+    void isReference(bool value) { is_reference=value; }
+    bool isReference() const { return is_reference; }
+
+    void isNoAlias(bool value) { is_noalias=value; }
+    bool isNoAlias() const { return is_noalias; }
 };
 
 class CastExprAST : public ExprAST
 {
     std::unique_ptr<ExprAST> expr;
-    std::unique_ptr<types::Base> dest_type;
+    types::Base* dest_type;
     bool is_non_user_defined;
 public:
-    CastExprAST(std::unique_ptr<ExprAST> expr, std::unique_ptr<types::Base> type, bool is_non_user_defined=false)
-    : expr(std::move(expr)), dest_type(std::move(type)), ExprAST("void",ast_cast), is_non_user_defined(is_non_user_defined)
+    CastExprAST(std::unique_ptr<ExprAST> expr, types::Base* type, bool is_non_user_defined=false)
+    : expr(std::move(expr)), dest_type(type), ExprAST("void",ast_cast), is_non_user_defined(is_non_user_defined)
     {}
 
     ExprAST* const getExpr() const 
@@ -153,7 +157,7 @@ public:
     }
     types::Base* getDestType() const 
     {
-        return dest_type.get();
+        return dest_type;
     }
     types::Base* getSourceType() const 
     {
@@ -164,13 +168,13 @@ public:
         return is_non_user_defined;
     }
 
-    void setDestType(std::unique_ptr<types::Base> type) 
+    void setDestType(types::Base* type) 
     {
-        dest_type=std::move(type);
+        dest_type=type;
     }
-    void setSourceType(std::unique_ptr<types::Base> type) 
+    void setSourceType(types::Base* type) 
     {
-        expr->setType(std::move(type));
+        expr->setType(type);
     }
 };
 
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <ostream>
 #include <memory>
+#include <cstdint>
+#include <utility>
 
 namespace vire
 {
@@ -52,7 +54,7 @@ inline std::unordered_map<EType, std::string> typestr_map=
     {EType::Custom, "custom"},
     {EType::Any, "any"},
 };
-inline std::unordered_map<std::string, int> custom_type_sizes=
+inline std::unordered_map<std::string, std::uint64_t> custom_type_sizes=
 { };
 
 // Prototypes
@@ -60,50 +62,42 @@ inline std::string getMapFromType(EType const& type);
 inline EType getTypeFromMap(std::string typestr);
 
 // Classes
+// Types are immutable and unique, they are only created by the `TypeTable` and compared by pointer
+class TypeTable;
+
 class Base
 {
 protected:
     EType type;
-    int8_t size;
-public:
-    int8_t precedence;
-    bool is_const;
-    bool is_signed;
-    
+    std::uint64_t size; // in bytes, the padding of structs is only known to the compiler's layout
+
     Base(bool _is_const=true)
     {
         type = EType::Void;
         size = 0;
+        precedence = 0;
         is_const = _is_const;
         is_signed = true;
     }
+    Base(Base const&)=delete;
+    Base& operator=(Base const&)=delete;
+public:
+    int8_t precedence;
+    bool is_const;
+    bool is_signed;
 
     virtual ~Base()=default;
     virtual EType const& getType() const { return type; }
-    virtual int8_t getSize() const { return size; }
+    virtual std::uint64_t getSize() const { return size; }
 
     virtual unsigned int getDepth() const { return 0; }
-
-    virtual void setSize(unsigned int new_size)
-    {
-        size=new_size;
-    }
-    
-    virtual bool isSame(Base* const other) const
-    {
-        return (getType() == other->getType()); 
-    }
-    virtual bool isSame(std::string const& other) const
-    {
-        return (getType() == getTypeFromMap(other)); 
-    }
 };
 
 inline bool isSame(Base* const a, Base* const b);
 inline bool isSame(Base* const a, const char*  b);
 
-inline std::unique_ptr<Base> construct(std::string typestr, bool create_custom=false);
-inline std::unique_ptr<Base> construct(EType const& type);
+inline Base* construct(std::string typestr, bool create_custom=false);
+inline Base* construct(EType const& type);
 inline Base* getArrayRootType(Base* const type);
 
 inline std::ostream& operator<<(std::ostream& os, Base const& type)
@@ -112,10 +106,13 @@ inline std::ostream& operator<<(std::ostream& os, Base const& type)
     return os;
 }
 
+// Void - `void`, or with a name the type of a struct that is not known yet
 class Void : public Base
 {
+    friend class TypeTable;
+
     std::string name;
-public:
+
     Void(std::string name="", bool _is_const=true)
     {
         type = EType::Void;
@@ -124,20 +121,17 @@ public:
         is_const=_is_const;
         this->name = name;
     }
-
+public:
     std::string const& getName() const
     {
         return name;
     }
-    void setName(std::string const& _name)
-    {
-        name=_name;
-    }
 };
 
 class Char : public Base
 {
-public:
+    friend class TypeTable;
+
     Char(bool _is_const=true)
     {
         type = EType::Char;
@@ -149,7 +143,8 @@ public:
 
 class Short : public Base
 {
-public:
+    friend class TypeTable;
+
     Short(bool _is_const=true)
     {
         type = EType::Short;
@@ -161,7 +156,8 @@ public:
 
 class Int : public Base
 {
-public:
+    friend class TypeTable;
+
     Int(bool _is_const=true)
     {
         type = EType::Int;
@@ -173,7 +169,8 @@ public:
 
 class Long : public Base
 {
-public:
+    friend class TypeTable;
+
     Long(bool _is_const=true)
     {
         type = EType::Long;
@@ -185,7 +182,8 @@ public:
 
 class Float : public Base
 {
-public:
+    friend class TypeTable;
+
     Float(bool _is_const=true)
     {
         type = EType::Float;
@@ -197,7 +195,8 @@ public:
 
 class Double : public Base
 {
-public:
+    friend class TypeTable;
+
     Double(bool _is_const=true)
     {
         type = EType::Double;
@@ -209,7 +208,8 @@ public:
 
 class Bool : public Base
 {
-public:
+    friend class TypeTable;
+
     Bool(bool _is_const=true)
     {
         type = EType::Bool;
@@ -221,41 +221,33 @@ public:
 
 class Array : public Base
 {
-    std::unique_ptr<Base> child;
+    friend class TypeTable;
+
+    Base* child;
     unsigned int length;
-public:
-    Array(std::unique_ptr<Base> b, int length, bool _is_const=true)
+
+    Array(Base* child, unsigned int length, bool _is_const=true)
     {
         this->type = EType::Array;
-        this->child = std::move(b);
+        this->child = child;
         this->length = length;
-        this->size = child->getSize() * length;
         is_const=_is_const;
     }
-    Array(Base* b, int length, bool _is_const=true)
+public:
+    Base* getChild() const 
     {
-        this->type = EType::Array;
-        this->child = std::unique_ptr<Base>(b);
-        this->length = length;
-        this->size = child->getSize() * length;
-        is_const=_is_const;
+        return child; 
     }
-
-    Base* getChild() const 
+    // Taken from the child, the size of a struct is set after the arrays of it are created
+    std::uint64_t getSize() const
     {
-        return child.get(); 
+        return child->getSize() * (std::uint64_t)length;
     }
     EType getChildType() const
     {
         return child->getType();
     }
 
-    void setChild(std::unique_ptr<Base> new_child)
-    {
-        child.release();
-        child = std::move(new_child);
-    }
-
     unsigned int getDepth() const
     {
         return child->getDepth() + 1;
@@ -264,75 +256,64 @@ public:
     {
         return length;
     }
-    void setLength(unsigned int new_length)
-    {
-        length = new_length;
-        size = child->getSize() * length;
-    }
 
-    bool isSame(Base* const other)
+    // Arrays of `void` are created from literals before their elements are known, they match any array of the same length
+    bool isSame(Array* const other) const
     {
-        if(other->getType() == EType::Array)
+        if(length != other->getLength())
         {
-            Array* other_array = static_cast<Array*>(other);
-
-            bool same_child = types::isSame(child.get(), other_array->getChild());
-            bool same_length = (length == other_array->getLength());
-       
-            bool b=false;
-
-            bool other_has_auto=getArrayRootType(other_array)->getType()==EType::Void;
-            bool this_has_auto=false;
-            if(child->getType()==EType::Array)
-            {
-                this_has_auto=getArrayRootType(static_cast<Array*>(child.get()))->getType()==EType::Void;
-            }
-            else
-            {
-                this_has_auto=child->getType()==EType::Void;
-            }
-
-            if(this_has_auto || other_has_auto)
-            {
-                b = same_length;
-            }
-            else
-            {
-                b = same_child && same_length;
-            }
-
-            return b;
+            return false;
         }
-        return false;
+
+        bool other_has_auto=getArrayRootType(other)->getType()==EType::Void;
+        bool this_has_auto=false;
+        if(child->getType()==EType::Array)
+        {
+            this_has_auto=getArrayRootType(child)->getType()==EType::Void;
+        }
+        else
+        {
+            this_has_auto=child->getType()==EType::Void;
+        }
+
+        if(this_has_auto || other_has_auto)
+        {
+            return true;
+        }
+        return types::isSame(child, other->getChild());
     }
 };
 
 class Custom : public Base
 {
+    friend class TypeTable;
+
     std::string name;
-public:
-    Custom(std::string name, long size, bool _is_const=true)
+
+    Custom(std::string name, std::uint64_t size, bool _is_const=true)
     : name(name)
     {
         this->type=EType::Custom;
         this->size=size;
         this->is_const=_is_const;
     }
-
+public:
     std::string const& getName() const 
     {
         return name;
     }
 
-    bool isSame(Custom* other)
+    // The size of a struct is only known once it is verified
+    void setSize(std::uint64_t new_size)
     {
-        return name==other->getName();
+        size=new_size;
     }
 };
 
 class Any : public Base
 {
-public:
+    friend class TypeTable;
+
     Any(bool _is_const=true)
     {
         this->type=EType::Any;
@@ -341,60 +322,119 @@ public:
     }
 };
 
-// Functions
-inline bool isSame(Base* const a, Base* const b)
+// TypeTable - Owns the only object of every distinct type
+// Nested types are keyed by the pointers of their children, so each lookup is a single hash probe
+class TypeTable
 {
-    if(a->getType() == b->getType())
+    struct ArrayKeyHash
     {
-        if(a->getType() != EType::Array)
+        std::size_t operator()(std::pair<Base*, unsigned int> const& key) const
         {
-            if(a->getType() == EType::Custom)
-            {
-                return a->isSame(b);
-            }
+            return std::hash<Base*>()(key.first) ^ (std::hash<unsigned int>()(key.second) * 0x9e3779b97f4a7c15ull);
+        }
+    };
 
-            return true;
+    std::unique_ptr<Base> primitives[(int)EType::Any+1];
+    std::unordered_map<std::pair<Base*, unsigned int>, std::unique_ptr<Array>, ArrayKeyHash> arrays;
+    std::unordered_map<std::string, std::unique_ptr<Custom>> customs;
+    std::unordered_map<std::string, std::unique_ptr<Void>> named_voids;
+public:
+    TypeTable()
+    {
+        primitives[(int)EType::Void]=std::unique_ptr<Base>(new Void());
+        primitives[(int)EType::Char]=std::unique_ptr<Base>(new Char());
+        primitives[(int)EType::Short]=std::unique_ptr<Base>(new Short());
+        primitives[(int)EType::Int]=std::unique_ptr<Base>(new Int());
+        primitives[(int)EType::Long]=std::unique_ptr<Base>(new Long());
+        primitives[(int)EType::Float]=std::unique_ptr<Base>(new Float());
+        primitives[(int)EType::Double]=std::unique_ptr<Base>(new Double());
+        primitives[(int)EType::Bool]=std::unique_ptr<Base>(new Bool());
+        primitives[(int)EType::Any]=std::unique_ptr<Base>(new Any());
+    }
+
+    // `void` for the types that are not a primitive
+    Base* getPrimitive(EType type) const
+    {
+        if(type==EType::Array || type==EType::Custom)
+        {
+            return primitives[(int)EType::Void].get();
         }
-        else
+        return primitives[(int)type].get();
+    }
+    Array* getArray(Base* child, unsigned int length)
+    {
+        auto& entry=arrays[std::make_pair(child, length)];
+        if(!entry)
         {
-            Array* a_array = static_cast<Array*>(a);
-            
-            bool f=a_array->isSame(b);
+            entry=std::unique_ptr<Array>(new Array(child, length));
+        }
+        return entry.get();
+    }
+    // Structs are kept for the whole run, modules of older versions of a source can still refer to them
+    Custom* getCustom(std::string const& name)
+    {
+        auto& entry=customs[name];
+        if(!entry)
+        {
+            entry=std::unique_ptr<Custom>(new Custom(name, 0));
+        }
+        return entry.get();
+    }
+    Void* getNamedVoid(std::string const& name)
+    {
+        if(name.empty())
+        {
+            return (Void*)primitives[(int)EType::Void].get();
+        }
 
-            return f;
+        auto& entry=named_voids[name];
+        if(!entry)
+        {
+            entry=std::unique_ptr<Void>(new Void(name));
         }
+        return entry.get();
     }
-    return false;
+};
+inline TypeTable type_table;
+
+inline Array* getArray(Base* child, unsigned int length)
+{
+    return type_table.getArray(child, length);
 }
-inline bool isSame(Base* const a, const char* b)
+inline Custom* getCustom(std::string const& name)
+{
+    return type_table.getCustom(name);
+}
+inline Void* getNamedVoid(std::string const& name)
 {
-    auto t=construct(b);
-    bool same=isSame(a, t.get());
-    return same;
+    return type_table.getNamedVoid(name);
 }
 
-inline std::unique_ptr<Base> copyType(Base* const type)
+// Functions
+inline bool isSame(Base* const a, Base* const b)
 {
-    if(type->getType() == EType::Array)
+    if(a == b)
     {
-        Array* array = static_cast<Array*>(type);
-        return std::make_unique<Array>(copyType(array->getChild()), array->getLength());
-    }
-    else if(type->getType() == EType::Custom)
-    {
-        auto* ctype=(Custom*)type;
-        return construct(ctype->getName(), true);
+        return true;
     }
-    else if(type->getType() == EType::Void)
+    if(a->getType() != b->getType())
     {
-        auto* vtype=(Void*)type;
-        return std::make_unique<types::Void>(vtype->getName());
+        return false;
     }
-    else
+
+    switch(a->getType())
     {
-        return construct(type->getType());
+        case EType::Array:  return static_cast<Array*>(a)->isSame(static_cast<Array*>(b));
+        case EType::Custom: return false;
+
+        // `void` with or without the name of a struct
+        default:            return true;
     }
 }
+inline bool isSame(Base* const a, const char* b)
+{
+    return isSame(a, construct(b));
+}
 
 inline void printAsArray(Base* const type)
 {
@@ -443,68 +483,31 @@ inline std::string getMapFromType(EType const& type)
     }
 }
 
-inline std::unique_ptr<Base> construct(std::string typestr, bool create_custom)
+inline Base* construct(std::string typestr, bool create_custom)
 {
     EType type=getTypeFromMap(typestr);
-    switch(type)
-    {
-        case EType::Void:
-            return std::make_unique<Void>();
-        case EType::Char:
-            return std::make_unique<Char>();
-        case EType::Short:
-            return std::make_unique<Short>();
-        case EType::Int:
-            return std::make_unique<Int>();
-        case EType::Long:
-            return std::make_unique<Long>();
-        case EType::Float:
-            return std::make_unique<Float>();
-        case EType::Double:
-            return std::make_unique<Double>();
-        case EType::Bool:
-            return std::make_unique<Bool>();
-        case EType::Custom:
-        {
-            if(!create_custom)
-            {
-                // std::cout << "Typestr: " << typestr << std::endl;
-                return std::make_unique<Void>(typestr);
-            }
-            
-            return std::make_unique<Custom>(typestr, custom_type_sizes.at(typestr));
-        }
-        case EType::Any:
-            return std::make_unique<Any>();
+    if(type!=EType::Custom)
+    {
+        return type_table.getPrimitive(type);
+    }
 
-        default:
-            return std::make_unique<Void>();
+    if(!create_custom)
+    {
+        return getNamedVoid(typestr);
     }
+
+    auto* custom=type_table.getCustom(typestr);
+    custom->setSize(custom_type_sizes.at(typestr));
+    return custom;
 }
-inline std::unique_ptr<Base> construct(EType const& type)
-{
-    switch(type)
-    {
-        case EType::Void:
-            return std::make_unique<Void>();
-        case EType::Char:
-            return std::make_unique<Char>();
-        case EType::Short:
-            return std::make_unique<Short>();
-        case EType::Int:
-            return std::make_unique<Int>();
-        case EType::Long:
-            return std::make_unique<Long>();
-        case EType::Float:
-            return std::make_unique<Float>();
-        case EType::Double:
-            return std::make_unique<Double>();
-        case EType::Bool:
-            return std::make_unique<Bool>();
-        
-        default:
-            return std::make_unique<Void>();
+inline Base* construct(EType const& type)
+{
+    // `any` is only created from its name
+    if(type==EType::Any)
+    {
+        return type_table.getPrimitive(EType::Void);
     }
+    return type_table.getPrimitive(type);
 }
 
 inline bool isUserDefined(EType type)
@@ -539,10 +542,27 @@ inline bool isTypeinMap(std::string name)
     return false;
 }
 
-inline void addTypeSizeToMap(std::string name, unsigned int size)
+inline void addTypeSizeToMap(std::string name, std::uint64_t size)
 {
     custom_type_sizes.insert(std::make_pair(name,size));
 }
+// Forgets the structs and unions of the previous source, so that it can be verified again
+inline void resetCustomTypes()
+{
+    std::erase_if(type_map, [](auto const& entry) { return entry.second==EType::Custom; });
+    custom_type_sizes.clear();
+}
+// Makes the structs and unions of a source verified earlier the current ones again, `sizes` is what `custom_type_sizes` was after it
+inline void restoreCustomTypes(std::unordered_map<std::string, std::uint64_t> const& sizes)
+{
+    resetCustomTypes();
+    for(auto const& [name, size] : sizes)
+    {
+        addTypeToMap(name);
+        addTypeSizeToMap(name, size);
+        type_table.getCustom(name)->setSize(size);
+    }
+}
 
 inline bool isNumericType(EType type)
 {
@@ -559,6 +579,14 @@ inline bool isNumericType(Base* type)
 {
     return isNumericType(type->getType());
 }
+inline bool isIntegerType(EType type)
+{
+    return (type==EType::Char) || (type==EType::Short) || (type==EType::Int) || (type==EType::Long);
+}
+inline bool isIntegerType(Base* type)
+{
+    return isIntegerType(type->getType());
+}
 
 } // namespace types
 } // namespace vire
\ No newline at end of file
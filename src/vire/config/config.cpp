@@ -7,18 +7,13 @@ namespace vire
 {
     void Config::installDefaultBinops() // default binops
     {
-        BinopPrecendence["<"]=10;
-        BinopPrecendence[">"]=10;
-        BinopPrecendence["<="]=10;
-        BinopPrecendence[">="]=10;
-        BinopPrecendence["=="]=10;
-        BinopPrecendence["!="]=10;
-        BinopPrecendence["+"]=20;
-        BinopPrecendence["-"]=20;
-        BinopPrecendence["*"]=40;
-        BinopPrecendence["/"]=40;
-        BinopPrecendence["%"]=40;
-        BinopPrecendence["**"]=60;
+        Binops=default_binops;
+    }
+    void Config::setBinop(int tok, int precedence, Associativity associativity)
+    {
+        if(tok>=0 || -tok>=(int)binop_table_size)
+            return;
+        Binops[-tok]={precedence, associativity};
     }
     void Config::installDefaultKeywords() // default keywords
     {
@@ -54,13 +49,6 @@ namespace vire
         KeywordTokenMap_end=KeywordTokenMap.end();
     }
     
-    int Config::getBinopPrecedence(std::string const& tok)
-    {
-        if(BinopPrecendence.contains(tok))
-            return BinopPrecendence.at(tok);
-        else
-            return -1;
-    }
     int Config::getKeywordToken(std::string const& keyw)
     {
         auto* keyword=Perfect_Hash::hash_keyword_to_token(keyw.c_str(), keyw.length());
@@ -48,17 +48,84 @@ inline std::unordered_map<Optimization, std::string> optimization_to_str=
     {Optimization::Oz, "Oz"},
 };
 
+// DebugInfo - The DWARF metadata emitted with a module, `-g0`, `-gline-tables-only` and `-g`
+enum class DebugInfo
+{
+    None,
+    LineTablesOnly,
+    Full,
+};
+
+inline std::unordered_map<std::string, DebugInfo> str_to_debug_info=
+{
+    {"g0", DebugInfo::None},
+    {"gline-tables-only", DebugInfo::LineTablesOnly},
+    {"g", DebugInfo::Full},
+};
+
+enum class Associativity
+{
+    Left,
+    Right,
+};
+
+struct BinopInfo
+{
+    int precedence; // -1 when the token is not a binary operator
+    Associativity associativity;
+};
+
+// Indexed by the negated `token`, the tokens are numbered down from `tok_eof`
+constexpr std::size_t binop_table_size=-(int)tok_at+1;
+typedef std::array<BinopInfo, binop_table_size> BinopTable;
+
+constexpr BinopTable makeDefaultBinops()
+{
+    BinopTable table{};
+    for(auto& info : table)
+    {
+        info={-1, Associativity::Left};
+    }
+
+    table[-tok_lessthan]={10, Associativity::Left};
+    table[-tok_morethan]={10, Associativity::Left};
+    table[-tok_lesseq]={10, Associativity::Left};
+    table[-tok_moreeq]={10, Associativity::Left};
+    table[-tok_dequal]={10, Associativity::Left};
+    table[-tok_nequal]={10, Associativity::Left};
+    table[-tok_plus]={20, Associativity::Left};
+    table[-tok_minus]={20, Associativity::Left};
+    table[-tok_mul]={40, Associativity::Left};
+    table[-tok_div]={40, Associativity::Left};
+    table[-tok_mod]={40, Associativity::Left};
+    return table;
+}
+inline constexpr BinopTable default_binops=makeDefaultBinops();
+
 class Config
 {
 public:
-    std::unordered_map<std::string, int> BinopPrecendence; // used by parser
+    BinopTable Binops; // used by parser
     std::unordered_map<std::string, int> KeywordTokenMap; // used by lexer
     std::unordered_map<std::string, int>::iterator KeywordTokenMap_end;
     
     void installDefaultBinops(); // default binops
     void installDefaultKeywords(); // default keywords
 
-    int getBinopPrecedence(std::string const& tok);
+    // Changes the precedence of an operator token for the sources parsed with this config
+    void setBinop(int tok, int precedence, Associativity associativity=Associativity::Left);
+
+    int getBinopPrecedence(int tok) const
+    {
+        return getBinop(tok).precedence;
+    }
+    BinopInfo const& getBinop(int tok) const
+    {
+        static constexpr BinopInfo none={-1, Associativity::Left};
+        if(tok>=0 || -tok>=(int)binop_table_size)
+            return none;
+        return Binops[-tok];
+    }
     int getKeywordToken(std::string const& keyw);
 };
 
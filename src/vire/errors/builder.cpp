@@ -22,25 +22,62 @@ namespace errors
     #define white_tag "\033[37m"
 
 
+    const char* errortypeToStr(errortypes type)
+    {
+        switch(type)
+        {
+            case errortypes::lex_unknown_char:       return "lex_unknown_char";
+            case errortypes::parse_unexpected_token: return "parse_unexpected_token";
+            case errortypes::parse_unexpected_eof:   return "parse_unexpected_eof";
+            case errortypes::analyze_requires_type:  return "analyze_requires_type";
+            default:                                 return "generic";
+        }
+    }
+    const char* severityToStr(Severity severity)
+    {
+        switch(severity)
+        {
+            case Severity::warning: return "warning";
+            case Severity::note:    return "note";
+            default:                return "error";
+        }
+    }
+
+    LineIndex::LineIndex(std::string_view source)
+    : source(source)
+    {
+        line_starts.push_back(0);
+        for(std::size_t i=0; i<source.size(); ++i)
+        {
+            if(source[i]=='\n' || source[i]=='\r')
+                line_starts.push_back(i+1);
+        }
+    }
+    std::string_view LineIndex::getLine(std::size_t line) const
+    {
+        if(line>=line_starts.size())
+            return {};
+
+        std::size_t begin=line_starts[line];
+        std::size_t end=line+1<line_starts.size() ? line_starts[line+1]-1 : source.size();
+        return source.substr(begin, end-begin);
+    }
+
     std::string ErrorBuilder::constructCodePosition
     (const std::string& input, std::size_t line, std::size_t column, int column_len)
+    {
+        return constructCodePosition(LineIndex(input), line, column, column_len);
+    }
+    std::string ErrorBuilder::constructCodePosition
+    (LineIndex const& index, std::size_t line, std::size_t column, int column_len)
     {
         std::string result;
-        
-        std::string code(input);
-        std::vector<std::string> lines;
-        std::size_t pos=0;
-        while((pos=code.find("\n"))!=std::string::npos)
-        {
-            lines.push_back(code.substr(0, pos));
-            code.erase(0, pos+1);
-        }
 
-        int start_pos=0;
-        int end_pos=line+1;
+        std::size_t start_pos=0;
+        std::size_t end_pos=line+1;
         if(line>2)  start_pos=end_pos-3;
 
-        for(int i=start_pos; i<end_pos; ++i)
+        for(std::size_t i=start_pos; i<end_pos; ++i)
         {
             result+=bold_tag;
             result+=std::to_string(i+1);
@@ -50,26 +87,93 @@ namespace errors
             if(i!=end_pos-1)
             {
                 result+=dull_tag;
-                result+=lines[i];
+                result+=index.getLine(i);
                 result+=reset_tag;
             }
             else
             {
                 result+=red_tag;
-                result+=lines[i];
+                result+=index.getLine(i);
                 result+=reset_tag;
             }
             result+="\n";
         }
         
-        for(int i=0; i<column+3; ++i) result+=" ";
+        // Under the column of the last line, after its `N |  ` gutter
+        result.append(std::to_string(end_pos).size()+4+column, ' ');
         result+=red_tag;
-        for(int i=0; i<column_len; ++i) result+="^";
+        result.append(column_len, '^');
         result+=reset_tag;
 
         return result;
     } 
 
+    void ErrorBuilder::setSource(std::string_view new_source)
+    {
+        source=new_source;
+        line_index.reset();
+    }
+    LineIndex const& ErrorBuilder::getLineIndex()
+    {
+        if(!line_index)
+        {
+            line_index=std::make_unique<LineIndex>(source);
+        }
+        return *line_index;
+    }
+
+    bool ErrorBuilder::addDiagnostic(Diagnostic diagnostic)
+    {
+        if(diagnostic.severity==Severity::error)
+        {
+            if(isAtLimit())
+            {
+                ++dropped_count;
+                return false;
+            }
+            ++error_count;
+        }
+
+        diagnostics.push_back(std::move(diagnostic));
+        return true;
+    }
+    bool ErrorBuilder::addError(std::string message, std::size_t line, std::size_t column, int column_len)
+    {
+        return addDiagnostic({errortypes::generic, Severity::error, std::move(message), line, column, (std::size_t)column_len, {}});
+    }
+    bool ErrorBuilder::addError(std::string message)
+    {
+        return addDiagnostic({errortypes::generic, Severity::error, std::move(message), 0, 0, 0, {}});
+    }
+
+    // Only the errors added since the last render are formatted
+    void ErrorBuilder::render()
+    {
+        for(; rendered_count<diagnostics.size(); ++rendered_count)
+        {
+            auto const& diagnostic=diagnostics[rendered_count];
+
+            std::string text;
+            if(diagnostic.length>0)
+            {
+                text+=constructCodePosition(getLineIndex(), diagnostic.line, diagnostic.column, diagnostic.length);
+                text+="\n";
+            }
+            text+=diagnostic.severity==Severity::error ? red_tag : yellow_tag;
+            text+=diagnostic.message;
+            text+=reset_tag;
+            for(auto const& note : diagnostic.notes)
+            {
+                text+="\n";
+                text+=magenta_tag;
+                text+="[Note]: ";
+                text+=note;
+                text+=reset_tag;
+            }
+            errors.push_back(std::move(text));
+        }
+    }
+
     /*
     template<>
     void ErrorBuilder::addError<lex_unknown_char>(const std::string& code, char _char, char fix, std::size_t line, std::size_t column)
@@ -151,12 +255,109 @@ namespace errors
     */
     void ErrorBuilder::showErrors()
     {
+        render();
         for(auto& error : this->errors)
         {
             std::cout << error << std::endl;
             std::cout << "----------------------------------------------------" << std::endl;
         }
+        if(dropped_count>0)
+        {
+            std::cout << dropped_count << " more errors were not reported, the limit is " << max_errors << std::endl;
+        }
+    }
+    std::vector<std::string> const& ErrorBuilder::getErrors()
+    {
+        render();
+        return errors;
+    }
+    void ErrorBuilder::clearErrors()
+    {
+        diagnostics.clear();
+        error_count=0;
+        dropped_count=0;
+        errors.clear();
+        rendered_count=0;
+    }
+
+
+    std::string ErrorBuilder::toPlainText(Diagnostic const& diagnostic)
+    {
+        std::string text;
+        if(diagnostic.length>0)
+        {
+            text+=std::to_string(diagnostic.line+1)+":"+std::to_string(diagnostic.column+1)+": ";
+        }
+        text+=severityToStr(diagnostic.severity);
+        text+=": ";
+        text+=diagnostic.message;
+        for(auto const& note : diagnostic.notes)
+        {
+            text+=" (note: "+note+")";
+        }
+        return text;
+    }
+
+    static void appendJSONString(std::string& out, std::string_view str)
+    {
+        out+='"';
+        for(unsigned char c : str)
+        {
+            switch(c)
+            {
+                case '"':  out+="\\\""; break;
+                case '\\': out+="\\\\"; break;
+                case '\n': out+="\\n"; break;
+                case '\r': out+="\\r"; break;
+                case '\t': out+="\\t"; break;
+                default:
+                {
+                    if(c<0x20)
+                    {
+                        static const char hex[]="0123456789abcdef";
+                        out+="\\u00";
+                        out+=hex[c>>4];
+                        out+=hex[c&0xf];
+                    }
+                    else
+                    {
+                        out+=(char)c;
+                    }
+                }
+            }
+        }
+        out+='"';
     }
+    std::string ErrorBuilder::toJSON() const
+    {
+        std::string out="{\"diagnostics\":[";
+        for(std::size_t i=0; i<diagnostics.size(); ++i)
+        {
+            auto const& diagnostic=diagnostics[i];
+            if(i>0) out+=',';
 
+            out+="{\"code\":";
+            appendJSONString(out, errortypeToStr(diagnostic.code));
+            out+=",\"severity\":";
+            appendJSONString(out, severityToStr(diagnostic.severity));
+            out+=",\"message\":";
+            appendJSONString(out, diagnostic.message);
+            if(diagnostic.length>0)
+            {
+                out+=",\"span\":{\"line\":"+std::to_string(diagnostic.line)
+                    +",\"column\":"+std::to_string(diagnostic.column)
+                    +",\"length\":"+std::to_string(diagnostic.length)+"}";
+            }
+            out+=",\"notes\":[";
+            for(std::size_t j=0; j<diagnostic.notes.size(); ++j)
+            {
+                if(j>0) out+=',';
+                appendJSONString(out, diagnostic.notes[j]);
+            }
+            out+="]}";
+        }
+        out+="],\"dropped\":"+std::to_string(dropped_count)+"}";
+        return out;
+    }
 }
 }
\ No newline at end of file
@@ -2,12 +2,16 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <memory>
 
 namespace vire
 {
     
 enum class errortypes
 {
+    generic, // errors that have no code of their own
+
     lex_unknown_char,
 
     parse_unexpected_token,
@@ -19,19 +23,84 @@ enum class errortypes
 namespace errors
 {
 
+enum class Severity
+{
+    error,
+    warning,
+    note,
+};
+
+const char* errortypeToStr(errortypes type);
+const char* severityToStr(Severity severity);
+
+// Diagnostic - One problem found in a source
+// `line` and `column` are zero based positions of the lexer, `length` is 0 for problems without a position
+struct Diagnostic
+{
+    errortypes code;
+    Severity severity;
+    std::string message;
+    std::size_t line;
+    std::size_t column;
+    std::size_t length;
+    std::vector<std::string> notes;
+};
+
+// LineIndex - The offsets where the lines of a source start, lines are counted like the lexer does, every '\n' and '\r' starts one
+class LineIndex
+{
+    std::string_view source;
+    std::vector<std::size_t> line_starts;
+public:
+    LineIndex(std::string_view source);
+
+    std::size_t getLineCount() const { return line_starts.size(); }
+    // Without the line break, empty past the last line
+    std::string_view getLine(std::size_t line) const;
+};
+
+// ErrorBuilder - Collects the diagnostics of a source, they are only rendered with the code around them when they are shown
+// After `max_errors` errors the following ones are dropped, `isAtLimit` tells the parser to stop
 class ErrorBuilder
 {
-    std::vector<std::string> errors;
+    std::vector<Diagnostic> diagnostics;
+    std::size_t error_count;
+    std::size_t max_errors; // 0 for no limit
+    std::size_t dropped_count;
     std::string prefix;
+    std::string_view source; // the source the positions refer to, owned by the caller
+
+    // Built on the first error that is rendered, and again when the source changes
+    std::unique_ptr<LineIndex> line_index;
+    std::vector<std::string> errors;
+    std::size_t rendered_count;
+
+    LineIndex const& getLineIndex();
+    void render();
 public:
     
-    ErrorBuilder() : prefix("This program") {};
-    ErrorBuilder(const std::string& prefix) : prefix(prefix) {};
+    ErrorBuilder() : ErrorBuilder("This program") {};
+    ErrorBuilder(const std::string& prefix)
+    : error_count(0), max_errors(0), dropped_count(0), prefix(prefix), rendered_count(0) {};
 
     void setPrefix(const std::string& newprefix) {prefix=newprefix;}
+    // The source has to outlive the errors that are added for it
+    void setSource(std::string_view new_source);
 
     std::string constructCodePosition
     (const std::string& input, std::size_t line, std::size_t column, int column_len=1);
+    std::string constructCodePosition
+    (LineIndex const& index, std::size_t line, std::size_t column, int column_len=1);
+
+    // Records the diagnostic, nothing is formatted until it is shown
+    // false when it was dropped because the error limit is reached
+    bool addDiagnostic(Diagnostic diagnostic);
+    bool addError(std::string message, std::size_t line, std::size_t column, int column_len=1);
+    bool addError(std::string message);
+
+    void setMaxErrors(std::size_t max) { max_errors=max; }
+    std::size_t getMaxErrors() const { return max_errors; }
+    bool isAtLimit() const { return max_errors!=0 && error_count>=max_errors; }
 
     template<errortypes X>
     void addError();
@@ -45,6 +114,16 @@ public:
     void addError(const std::string& code, unsigned char islet, const std::string& varname="my_var", std::size_t line=0, std::size_t column=0); // <errortypes::analyzer_requires_type>
 
     void showErrors();
+    std::vector<std::string> const& getErrors();
+    std::vector<Diagnostic> const& getDiagnostics() const { return diagnostics; }
+    std::size_t getErrorCount() const { return error_count; }
+    std::size_t getDroppedCount() const { return dropped_count; }
+    void clearErrors();
+
+    // One line for each diagnostic, `line:column: severity: message`, with the positions one based
+    static std::string toPlainText(Diagnostic const& diagnostic);
+    // {"diagnostics": [{"code", "severity", "message", "span": {"line", "column", "length"}, "notes"}], "dropped"}
+    std::string toJSON() const;
 };
 
 }
@@ -7,5 +7,6 @@
 #include "proto/include.hpp"
 #include "v_analyzer/include.hpp"
 #include "v_compiler/include.hpp"
+#include "serial/include.hpp"
 #include "config/include.hpp"
 #include "api/include.hpp"
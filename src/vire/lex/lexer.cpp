@@ -23,17 +23,31 @@ protected:
     std::size_t indx;
     std::size_t line;
     std::size_t charpos;
+    std::size_t start_line;
+    std::size_t start_charpos;
     errors::ErrorBuilder* builder; // error builder
     std::unique_ptr<Config> config;
+    const char* buf; // `code`, or a buffer owned by the caller such as a mapped file
+    bool external;
 public:
     bool jit;
     std::string code;
     std::size_t len;
 
     VLexer(std::string code, errors::ErrorBuilder* builder)
-    : builder(builder), jit(false)
+    : start_line(0), start_charpos(0), builder(builder), external(false), jit(false)
+    {
+        this->code=std::move(code);
+        config=std::make_unique<Config>();
+        config->installDefaultBinops();
+        config->installDefaultKeywords();
+        reset();
+    }
+
+    // Lexes `size` bytes at `data` in place, the buffer has to outlive the lexer
+    VLexer(const char* data, std::size_t size, errors::ErrorBuilder* builder)
+    : start_line(0), start_charpos(0), builder(builder), buf(data), external(true), jit(false), len(size)
     {
-        this->code=code;
         config=std::make_unique<Config>();
         config->installDefaultBinops();
         config->installDefaultKeywords();
@@ -44,24 +58,70 @@ public:
     {
         return config.get();
     }
+    errors::ErrorBuilder* const getErrorBuilder() const
+    {
+        return builder;
+    }
 
     void reset()
     {
         this->cur=' ';
         this->indx=-1;
-        this->line=0;
+        this->line=start_line;
 
-        if(!jit)
-        {
-            this->len=code.length();
-        }
-        else
+        if(jit)
         {
             this->code="";
             this->len=0;
+            this->external=false;
+        }
+        if(!external)
+        {
+            this->buf=code.data();
+            this->len=code.length();
         }
 
-        this->charpos=-1;
+        this->charpos=start_charpos-1;
+    }
+
+    // Lexes another source with the same configuration
+    void setCode(std::string const& new_code)
+    {
+        code=new_code;
+        external=false;
+        reset();
+    }
+
+    // The code is a part of a bigger source, `line` and `charpos` are what `getLine` and `getCharpos` 
+    // returned at its first character while lexing the whole source, used for reparsing a changed region
+    void setStartPosition(std::size_t line, std::size_t charpos)
+    {
+        start_line=line;
+        start_charpos=charpos-1;
+        reset();
+    }
+    // Offset in the code right after the last token that was lexed
+    std::size_t getOffset() const
+    {
+        return this->cur==EOF ? this->len : this->indx;
+    }
+    // Column of the character at `offset`, counted from the line break before it
+    // Unlike the charpos of tokens it does not drift with the whitespace and the operators before it
+    std::size_t getColumn(std::size_t offset) const
+    {
+        std::size_t end=offset<this->len ? offset : this->len;
+        std::size_t begin=end;
+        while(begin>0 && this->buf[begin-1]!='\n' && this->buf[begin-1]!='\r')
+            --begin;
+        return end-begin;
+    }
+    std::size_t getLine() const
+    {
+        return this->line;
+    }
+    std::size_t getCharpos() const
+    {
+        return this->charpos;
     }
     char getNext(char move_amt=0)
     {
@@ -71,7 +131,7 @@ public:
         this->indx+=move_amt+1;
         this->charpos++;
         
-        return this->code.at(this->indx);
+        return this->buf[this->indx];
     }
     void advanceNext(char move_amt=0)
     {
@@ -82,7 +142,7 @@ public:
     {
         if(this->indx+amt>this->len-1)  return EOF;
 
-        return this->code.at(this->indx+amt);
+        return this->buf[this->indx+amt];
     }
 
     std::string gatherId()
@@ -300,6 +360,7 @@ public:
             }
 
             case '.': return makeToken(".",tok_dot);
+            case '@': return makeToken("@",tok_at);
 
             case '\'': return gatherChar();
             case '"':  return gatherStr();
@@ -317,6 +378,7 @@ public:
     {
         auto old_str=code;
         code=str;
+        buf=code.data();
         auto tkn=getToken();
         old_str=code;
         return std::move(tkn);
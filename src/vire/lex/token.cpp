@@ -155,6 +155,8 @@ static const char* tokToStr(int tok)
 
         case tok_as: return "tok_as";
 
+        case tok_at: return "tok_at";
+
         default: return "unknown";
     }
 }
@@ -6,6 +6,8 @@ add_library(
 
     ${SRC_DIR}/src/vire/parse/parser.hpp
     ${SRC_DIR}/src/vire/parse/parser.cpp
+    ${SRC_DIR}/src/vire/parse/incremental.hpp
+    ${SRC_DIR}/src/vire/parse/incremental.cpp
 )
 
 target_link_libraries(VIRELANG PRIVATE vire-parser)
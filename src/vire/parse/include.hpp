@@ -1,4 +1,5 @@
 #pragma once
 
 #include "parser.hpp"
+#include "incremental.hpp"
 #include "keyword_hash.hpp"
\ No newline at end of file
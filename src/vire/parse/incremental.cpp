@@ -0,0 +1,214 @@
+#include "incremental.hpp"
+
+#include "vire/serial/ast_cache.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace vire
+{
+    // Lines as the lexer counts them, every '\n' and '\r' starts a new one
+    static long countLines(std::string const& code, std::size_t begin, std::size_t end)
+    {
+        return std::count_if(code.begin()+begin, code.begin()+end, [](char c) { return c=='\n' || c=='\r'; });
+    }
+
+    void VIncrementalParser::reset()
+    {
+        source.clear();
+        declarations.clear();
+        has_cache=false;
+        reused_count=0;
+        parsed_count=0;
+    }
+
+    bool VIncrementalParser::writeDeclarations(ModuleAST* const mod, std::vector<SourceDeclaration> const& decls,
+        std::size_t offset, std::vector<CachedDeclaration>& out)
+    {
+        std::size_t import_indx=0, func_indx=0, union_struct_indx=0, stm_indx=0;
+        for(auto const& decl : decls)
+        {
+            std::string data;
+            switch(decl.kind)
+            {
+                case decl_import:
+                    data=mod->getImports()[import_indx++];
+                    break;
+                case decl_function:
+                    data=serial::writeDeclaration(mod->getFunctions()[func_indx++].get());
+                    break;
+                case decl_union_struct:
+                    data=serial::writeDeclaration(mod->getUnionStructs()[union_struct_indx++].get());
+                    break;
+                case decl_statement:
+                    data=serial::writeDeclaration(mod->getPreExecutionStatements()[stm_indx++].get());
+                    break;
+                case decl_class:
+                    // Classes have no binary form, sources with them are always parsed completely
+                    return false;
+            }
+
+            if(data.empty())
+                return false;
+
+            out.push_back({decl.kind, decl.begin+offset, decl.end+offset, decl.end_line, decl.end_charpos, 0, std::move(data)});
+        }
+        return true;
+    }
+
+    std::unique_ptr<ModuleAST> VIncrementalParser::buildModule()
+    {
+        std::vector<std::unique_ptr<ExprAST>> stms;
+        std::vector<std::unique_ptr<FunctionBaseAST>> funcs;
+        std::vector<std::unique_ptr<ExprAST>> union_structs;
+        std::vector<std::string> imports;
+
+        for(auto const& decl : declarations)
+        {
+            switch(decl.kind)
+            {
+                case decl_import:
+                    imports.push_back(decl.data);
+                    break;
+                case decl_function:
+                {
+                    auto func=serial::readFunctionDeclaration(decl.data, decl.line_shift);
+                    if(!func)   return nullptr;
+                    funcs.push_back(std::move(func));
+                    break;
+                }
+                case decl_union_struct:
+                case decl_statement:
+                {
+                    auto expr=serial::readExprDeclaration(decl.data, decl.line_shift);
+                    if(!expr)   return nullptr;
+                    (decl.kind==decl_statement ? stms : union_structs).push_back(std::move(expr));
+                    break;
+                }
+                case decl_class:
+                    return nullptr;
+            }
+        }
+
+        auto mod=std::make_unique<ModuleAST>(std::move(stms), std::move(funcs), std::vector<std::unique_ptr<ClassAST>>(), std::move(union_structs));
+        for(auto const& name : imports)
+        {
+            mod->addImport(name);
+        }
+        return mod;
+    }
+
+    std::unique_ptr<ModuleAST> VIncrementalParser::parseFull(std::string const& new_source)
+    {
+        reset();
+
+        VParser parser(std::make_unique<VLexer>(new_source, builder));
+        auto mod=parser.ParseSourceModule();
+        if(!mod)
+            return nullptr;
+
+        reused_count=0;
+        parsed_count=parser.getDeclarations().size();
+
+        // The module is written before it is returned, the analyzer changes it while verifying
+        if(writeDeclarations(mod.get(), parser.getDeclarations(), 0, declarations))
+        {
+            source=new_source;
+            has_cache=true;
+        }
+        else
+        {
+            declarations.clear();
+        }
+        return mod;
+    }
+
+    std::unique_ptr<ModuleAST> VIncrementalParser::parse(std::string const& new_source)
+    {
+        if(!has_cache)
+            return parseFull(new_source);
+
+        // The edit replaced [prefix, old_len-suffix) of the old source by [prefix, new_len-suffix) of the new one
+        std::size_t old_len=source.size(), new_len=new_source.size();
+        std::size_t prefix=0;
+        while(prefix<old_len && prefix<new_len && source[prefix]==new_source[prefix])
+            prefix++;
+        std::size_t suffix=0;
+        while(suffix<old_len-prefix && suffix<new_len-prefix && source[old_len-suffix-1]==new_source[new_len-suffix-1])
+            suffix++;
+
+        long len_shift=(long)new_len-(long)old_len;
+        long line_shift=countLines(new_source, prefix, new_len-suffix)-countLines(source, prefix, old_len-suffix);
+
+        // A declaration before the edit is kept when the character after its last token did not change
+        // A statement is not, `if` looks at the token after it for an `else`
+        std::size_t leading=0;
+        while(leading<declarations.size() && declarations[leading].end<prefix)
+            leading++;
+        if(leading>0 && declarations[leading-1].kind==decl_statement)
+            leading--;
+
+        // A declaration after the edit is kept when a new line separates it from the edit, so its columns stay the same
+        std::size_t trailing=declarations.size();
+        while(trailing>leading && declarations[trailing-1].begin>=old_len-suffix)
+        {
+            auto const& decl=declarations[trailing-1];
+            bool separated=false;
+            for(std::size_t i=new_len-suffix; i<decl.end+len_shift; i++)
+            {
+                char c=new_source[i];
+                if(c=='\n' || c=='\r')
+                {
+                    separated=true;
+                    break;
+                }
+                if(i>=decl.begin+len_shift && !std::isspace((unsigned char)c))
+                    break;
+            }
+            if(!separated)
+                break;
+            trailing--;
+        }
+
+        // Only the code between the kept declarations is parsed, the lexer starts where the last kept one ended
+        std::size_t chunk_begin=leading>0 ? declarations[leading-1].end : 0;
+        std::size_t chunk_end=trailing<declarations.size() ? declarations[trailing].begin+len_shift : new_len;
+
+        auto lexer=std::make_unique<VLexer>(new_source.substr(chunk_begin, chunk_end-chunk_begin), builder);
+        if(leading>0)
+            lexer->setStartPosition(declarations[leading-1].end_line, declarations[leading-1].end_charpos);
+
+        VParser parser(std::move(lexer));
+        auto chunk=parser.ParseSourceModule();
+        if(!chunk)
+        {
+            reset();
+            return nullptr;
+        }
+
+        std::vector<CachedDeclaration> parsed;
+        if(!writeDeclarations(chunk.get(), parser.getDeclarations(), chunk_begin, parsed))
+            return parseFull(new_source);
+
+        for(std::size_t i=trailing; i<declarations.size(); i++)
+        {
+            auto& decl=declarations[i];
+            decl.begin+=len_shift;
+            decl.end+=len_shift;
+            decl.end_line+=line_shift;
+            decl.line_shift+=line_shift;
+        }
+
+        declarations.erase(declarations.begin()+leading, declarations.begin()+trailing);
+        declarations.insert(declarations.begin()+leading, std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+        source=new_source;
+
+        reused_count=declarations.size()-parsed.size();
+        parsed_count=parsed.size();
+
+        auto mod=buildModule();
+        if(!mod)
+            return parseFull(new_source);
+        return mod;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "parser.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace vire
+{
+
+// VIncrementalParser - Parses new versions of a source, reusing the top-level declarations whose code did not change
+// Declarations are kept in the binary form of the AST cache, the module returned by `parse` is owned by the caller
+class VIncrementalParser
+{
+    struct CachedDeclaration
+    {
+        DeclarationKind kind;
+        std::size_t begin;
+        std::size_t end;
+        std::size_t end_line;
+        std::size_t end_charpos;
+        long line_shift; // lines the declaration moved since it was written
+        std::string data; // the written declaration, the module name for imports
+    };
+
+    errors::ErrorBuilder* builder;
+    std::string source;
+    std::vector<CachedDeclaration> declarations;
+    bool has_cache;
+
+    unsigned int reused_count;
+    unsigned int parsed_count;
+private:
+    std::unique_ptr<ModuleAST> parseFull(std::string const& new_source);
+    std::unique_ptr<ModuleAST> buildModule();
+    bool writeDeclarations(ModuleAST* const mod, std::vector<SourceDeclaration> const& decls,
+        std::size_t offset, std::vector<CachedDeclaration>& out);
+public:
+    VIncrementalParser(errors::ErrorBuilder* builder)
+    : builder(builder), has_cache(false), reused_count(0), parsed_count(0) {}
+
+    // Parses `new_source`, nullptr is returned when it has parse errors
+    std::unique_ptr<ModuleAST> parse(std::string const& new_source);
+    void reset();
+
+    // Declarations taken from the previous source and parsed again by the last `parse`
+    unsigned int getReusedCount() const { return reused_count; }
+    unsigned int getParsedCount() const { return parsed_count; }
+};
+
+}
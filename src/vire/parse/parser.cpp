@@ -1,15 +1,99 @@
 #include "parser.hpp"
 
-#define ERR_OUT stdout
+#include <iostream>
+#include <cstdio>
+#include <algorithm>
+#include <charconv>
+#include <limits>
 
 namespace vire
 {
+    // Parse errors are kept as diagnostics by the error builder of the lexer
+    // Without a builder they go to std::cout like the messages of the analyzer, so redirecting it collects both
+    // Only the first error of a statement is reported, the ones after it follow from it until the parser recovers
+    void VParser::reportError(const char* str, std::va_list args)
+    {
+        parse_success=false;
+        if(panicking)
+            return;
+        panicking=true;
+
+        std::va_list len_args;
+        va_copy(len_args,args);
+        int len=std::vsnprintf(nullptr,0,str,len_args);
+        va_end(len_args);
+
+        std::string message(len>0 ? len : 0, '\0');
+        std::vsnprintf(message.data(),message.size()+1,str,args);
+        while(!message.empty() && message.back()=='\n')
+            message.pop_back();
+
+        auto* builder=lexer->getErrorBuilder();
+        if(!builder)
+        {
+            std::cout << "Parse Error: " << message << std::endl;
+            return;
+        }
+
+        // The current token ends where the lexer is
+        auto const& value=current_token->value;
+        std::size_t end=lexer->getOffset();
+        std::size_t column=lexer->getColumn(end>=value.size() ? end-value.size() : 0);
+        std::size_t length=std::max<std::size_t>(value.size(), 1);
+        auto code=current_token->type==tok_eof ? errortypes::parse_unexpected_eof : errortypes::parse_unexpected_token;
+        builder->addDiagnostic({code, errors::Severity::error, std::move(message), current_token->line, column, length, {}});
+    }
+    bool VParser::isAtErrorLimit() const
+    {
+        auto* builder=lexer->getErrorBuilder();
+        return builder && builder->isAtLimit();
+    }
+
+    // A statement ends at its ';', or at the '}' of the block it is in, which is left for the block
+    void VParser::synchronizeStatement()
+    {
+        while(current_token->type!=tok_eof && current_token->type!=tok_rbrace)
+        {
+            if(current_token->type==tok_semicol)
+            {
+                getNextToken();
+                break;
+            }
+            getNextToken();
+        }
+        panicking=false;
+    }
+    void VParser::synchronizeDeclaration()
+    {
+        while(current_token->type!=tok_eof && !isDeclarationStart())
+        {
+            getNextToken();
+        }
+        panicking=false;
+    }
+    bool VParser::isDeclarationStart() const
+    {
+        switch(current_token->type)
+        {
+            case tok_func:
+            case tok_proto:
+            case tok_extern:
+            case tok_class:
+            case tok_struct:
+            case tok_union:
+                return true;
+            case tok_id:
+                return current_token->value=="import";
+            default:
+                return false;
+        }
+    }
+
     std::unique_ptr<ExprAST> VParser::LogError(const char* str,...)
     {
         std::va_list args;
         va_start(args,str);
-        fprintf(ERR_OUT,"Parse Error: ");
-        std::vfprintf(ERR_OUT,str,args);
+        reportError(str,args);
         va_end(args);
         return nullptr;
     }
@@ -17,8 +101,7 @@ namespace vire
     {
         std::va_list args;
         va_start(args,str);
-        fprintf(ERR_OUT,"Parse Error: ");
-        std::vfprintf(ERR_OUT,str,args);
+        reportError(str,args);
         va_end(args);
         return nullptr;
     }
@@ -26,8 +109,7 @@ namespace vire
     {
         std::va_list args;
         va_start(args,str);
-        fprintf(ERR_OUT,"Parse Error: ");
-        std::vfprintf(ERR_OUT,str,args);
+        reportError(str,args);
         va_end(args);
         return nullptr;
     }
@@ -35,8 +117,7 @@ namespace vire
     {
         std::va_list args;
         va_start(args,str);
-        fprintf(ERR_OUT,"Parse Error: ");
-        std::vfprintf(ERR_OUT,str,args);
+        reportError(str,args);
         va_end(args);
         return nullptr;
     }
@@ -44,19 +125,17 @@ namespace vire
     {
         std::va_list args;
         va_start(args,str);
-        fprintf(ERR_OUT,"Parse Error: ");
-        std::vfprintf(ERR_OUT,str,args);
+        reportError(str,args);
         va_end(args);
         return std::vector<std::unique_ptr<ExprAST>>();
     }
-    std::pair<std::unordered_map<proto::IName, std::unique_ptr<ExprAST>>, std::unique_ptr<FunctionAST>> VParser::LogErrorPB(const char* str,...)
+    PrimitiveBody VParser::LogErrorPB(const char* str,...)
     {
         std::va_list args;
         va_start(args,str);
-        fprintf(ERR_OUT,"Parse Error: ");
-        std::vfprintf(ERR_OUT,str,args);
+        reportError(str,args);
         va_end(args);
-        return std::pair<std::unordered_map<proto::IName, std::unique_ptr<ExprAST>>, std::unique_ptr<FunctionAST>>();
+        return PrimitiveBody();
     }
 
     void VParser::getNextToken(bool first_token)
@@ -67,6 +146,9 @@ namespace vire
             return;
         }
 
+        prev_token_end=lexer->getOffset();
+        prev_token_line=lexer->getLine();
+        prev_token_charpos=lexer->getCharpos();
         current_token.reset();
         current_token=lexer->getToken();
 
@@ -92,7 +174,7 @@ namespace vire
         return std::make_unique<VToken>(current_token->value, current_token->type, current_token->line, current_token->charpos);
     }
 
-    std::unique_ptr<types::Base> VParser::ParseTypeIdentifier()
+    types::Base* VParser::ParseTypeIdentifier()
     {
         auto main_type_tok=copyCurrentToken();
         auto main_type=types::construct(main_type_tok->value);
@@ -104,17 +186,16 @@ namespace vire
             auto arr_num=std::stoi(current_token->value);
             getNextToken(tok_int);
 
-            auto main_type_child=std::move(main_type);
-            main_type=std::make_unique<types::Array>(std::move(main_type_child), arr_num);
+            main_type=types::getArray(main_type, arr_num);
             getNextToken(tok_rbrack);
         }
 
         if(main_type->getType() == types::EType::Void)
         {
-            ((types::Void*)main_type.get())->setName(proto::IName(main_type_tok->value).get());
+            main_type=types::getNamedVoid(proto::IName(main_type_tok->value).get());
         }
 
-        return std::move(main_type);
+        return main_type;
     }
     std::vector<std::unique_ptr<ExprAST>> VParser::ParseBlock()
     {
@@ -128,18 +209,21 @@ namespace vire
                 parse_success=false;
                 return LogErrorVP("Expected '}', found end of file");
             }
+            if(isAtErrorLimit())
+            {
+                return stms;
+            }
             
+            panicking=false;
+            auto stm_begin=lexer->getOffset();
             auto stm=ParsePrimary();
-            while(!stm)
+            if(!stm)
             {
-                if(current_token->type==tok_eof)
-                {
-                    parse_success=false;
-                    return LogErrorVP("Expected statement, found end of file");
-                }
-
-                getNextToken();
-                stm=ParsePrimary();
+                // Nothing of the statement is kept, the token it failed at is skipped when it was its first one
+                if(lexer->getOffset()==stm_begin)
+                    getNextToken();
+                synchronizeStatement();
+                continue;
             }
 
             if(stm->asttype==ast_return) 
@@ -155,6 +239,8 @@ namespace vire
                 getNextToken(tok_semicol);
 
             stms.push_back(std::move(stm));
+            if(panicking)
+                synchronizeStatement();
         }
 
         getNextToken(tok_rbrace);
@@ -193,6 +279,7 @@ namespace vire
 
             case tok_for: return ParseForExpr();
             case tok_while: return ParseWhileExpr();
+            case tok_at: return ParseLoopExpr();
 
             case tok_if: return ParseIfExpr();
 
@@ -422,7 +509,7 @@ namespace vire
         {
             getNextToken();
             auto type=ParseTypeIdentifier();
-            stm=std::make_unique<CastExprAST>(std::move(stm), std::move(type), true);
+            stm=std::make_unique<CastExprAST>(std::move(stm), type, true);
         }
         else
         {
@@ -440,7 +527,7 @@ namespace vire
     {
         while(1)
         {  
-            int prec=config->getBinopPrecedence(current_token->value);
+            int prec=config->getBinopPrecedence(current_token->type);
  
             if(prec<ExprPrec && !(current_token->type==tok_and || current_token->type==tok_or))
                 return LHS;
@@ -459,10 +546,12 @@ namespace vire
             if(!RHS)
                 return nullptr;
             
-            int nextprec=config->getBinopPrecedence(current_token->value.c_str());
-            if(prec<nextprec)
+            // A right-associative operator takes the operators of the same precedence that follow it into its RHS
+            auto const& next=config->getBinop(current_token->type);
+            bool right_assoc=next.associativity==Associativity::Right;
+            if(prec<next.precedence || (right_assoc && prec==next.precedence))
             {
-                RHS=ParseBinopExpr(prec+1,std::move(RHS));
+                RHS=ParseBinopExpr(right_assoc ? prec : prec+1,std::move(RHS));
                 if(!RHS)
                     return nullptr;
             }
@@ -493,24 +582,17 @@ namespace vire
         getNextToken(tok_id);
 
         bool is_array=false;
-        std::unique_ptr<types::Base> type;
-        types::Array* type_ref;
+        types::Base* type;
+        // The lengths from the innermost array, which is only built once the type of its elements is parsed
+        std::vector<unsigned int> lengths;
 
-        if(current_token->type==tok_lbrack)
+        while(current_token->type==tok_lbrack)
         {
             is_array=true;
             getNextToken(tok_lbrack);
-            type=std::make_unique<types::Array>(std::make_unique<types::Void>(), std::stoi(current_token->value));
-            type_ref=(types::Array*)type.get();
+            lengths.push_back(std::stoi(current_token->value));
             getNextToken(tok_int);
             getNextToken(tok_rbrack);
-            while(current_token->type==tok_lbrack)
-            {
-                getNextToken(tok_lbrack);
-                type=std::make_unique<types::Array>(std::move(type), std::stoi(current_token->value));
-                getNextToken(tok_int);
-                getNextToken(tok_rbrack);
-            }
         }
 
         if(is_array)
@@ -518,12 +600,17 @@ namespace vire
             if(current_token->type==tok_colon)
             {
                 getNextToken(tok_colon);
-                type_ref->setChild(ParseTypeIdentifier());
+                type=ParseTypeIdentifier();
             }
             else
             {
                 // Automatic type inference
-                type_ref->setChild(types::construct("void"));
+                type=types::construct("void");
+            }
+
+            for(auto length : lengths)
+            {
+                type=types::getArray(type, length);
             }
         }
         else
@@ -553,16 +640,16 @@ namespace vire
         if(is_array && value!=nullptr)
         {
             auto* vtype=(types::Array*)value->getType();
-            auto* stype=(types::Array*)type.get();
+            auto* stype=(types::Array*)type;
             
             if(vtype->getLength() <= stype->getLength())
             {
-                vtype->setLength(stype->getLength());
+                value->setType(types::getArray(vtype->getChild(), stype->getLength()));
             }
 
         }
 
-        return std::make_unique<VariableDefAST>(std::move(var_name), std::move(type), std::move(value), isconst, islet);
+        return std::make_unique<VariableDefAST>(std::move(var_name), type, std::move(value), isconst, islet);
     }
     std::unique_ptr<ExprAST> VParser::ParseVariableAssign(std::unique_ptr<ExprAST> expr)
     {
@@ -645,6 +732,95 @@ namespace vire
 
         return std::make_unique<WhileExprAST>(std::move(cond), std::move(Stms));
     }
+    std::unique_ptr<ExprAST> VParser::ParseLoopExpr()
+    {
+        auto hints=ParseLoopHints();
+
+        if(current_token->type==tok_for)
+        {
+            auto loop=ParseForExpr();
+            ((ForExprAST*)loop.get())->setHints(hints);
+            return loop;
+        }
+        if(current_token->type==tok_while)
+        {
+            auto loop=ParseWhileExpr();
+            ((WhileExprAST*)loop.get())->setHints(hints);
+            return loop;
+        }
+
+        parse_success=false;
+        return LogError("Expected `for` or `while` after loop hints, found `%s`\n", current_token->value.c_str());
+    }
+    LoopHints VParser::ParseLoopHints()
+    {
+        LoopHints hints;
+        while(current_token->type==tok_at)
+        {
+            getNextToken(tok_at); // consume '@'
+
+            auto name=current_token->value;
+            if(current_token->type!=tok_id)
+            {
+                LogError("Expected loop hint name after '@'\n");
+                parse_success=false;
+                return hints;
+            }
+            getNextToken(tok_id); // consume hint name
+
+            if(name=="parallel")
+            {
+                hints.parallel=true;
+                continue;
+            }
+            if(name=="nounroll")
+            {
+                hints.unroll_disable=true;
+                continue;
+            }
+            if(name=="novectorize")
+            {
+                hints.vectorize_disable=true;
+                continue;
+            }
+            if(name=="unroll" && current_token->type!=tok_lparen)
+            {
+                hints.unroll_full=true;
+                continue;
+            }
+
+            unsigned int* value;
+            if(name=="unroll")          value=&hints.unroll_count;
+            else if(name=="vectorize")  value=&hints.vectorize_width;
+            else if(name=="interleave") value=&hints.interleave_count;
+            else
+            {
+                LogError("Unknown loop hint `%s`\n", name.c_str());
+                parse_success=false;
+                continue;
+            }
+
+            // `@hint(n)` - n must be a positive integer literal that fits an unsigned int
+            getNextToken(tok_lparen);
+            std::uint64_t count=0;
+            auto const& text=current_token->value;
+            auto [end, ec]=std::from_chars(text.data(), text.data()+text.size(), count);
+            if(current_token->type!=tok_int || ec!=std::errc() || end!=text.data()+text.size()
+                || count==0 || count>std::numeric_limits<unsigned int>::max())
+            {
+                LogError("Loop hint `%s` expects a positive integer, found `%s`\n", name.c_str(), text.c_str());
+                parse_success=false;
+            }
+            else
+            {
+                *value=(unsigned int)count;
+            }
+            getNextToken(); // consume count
+            getNextToken(tok_rparen);
+        }
+
+        return hints;
+    }
     std::unique_ptr<ExprAST> VParser::ParseBreakContinue()
     {
         bool is_break=1;
@@ -672,6 +848,38 @@ namespace vire
         }
     }
 
+    unsigned int VParser::ParseFunctionAttributes()
+    {
+        static const std::unordered_map<std::string, FunctionAttribute> attribute_names=
+        {
+            {"inline", fattr_inline},
+            {"noinline", fattr_noinline},
+            {"pure", fattr_pure},
+            {"readonly", fattr_readonly},
+            {"hot", fattr_hot},
+            {"cold", fattr_cold},
+        };
+
+        unsigned int attributes=fattr_none;
+        while(current_token->type==tok_at)
+        {
+            getNextToken(tok_at); // consume '@'
+
+            auto it=attribute_names.find(current_token->value);
+            if(current_token->type!=tok_id || it==attribute_names.end())
+            {
+                LogError("Unknown function attribute `%s`\n", current_token->value.c_str());
+                parse_success=false;
+            }
+            else
+            {
+                attributes|=it->second;
+            }
+            getNextToken(); // consume attribute name
+        }
+
+        return attributes;
+    }
     std::unique_ptr<PrototypeAST> VParser::ParsePrototype()
     {
         if(current_token->type!=tok_id)
@@ -685,16 +893,41 @@ namespace vire
         getNextToken(); // consume '('
 
         std::vector<std::unique_ptr<VariableDefAST>> args;
-        while(current_token->type==tok_id)
+        while(current_token->type==tok_id || current_token->type==tok_at)
         {
+            // `@noalias` - the argument does not alias any other pointer in the function
+            bool is_noalias=false;
+            while(current_token->type==tok_at)
+            {
+                getNextToken(tok_at); // consume '@'
+                if(current_token->value!="noalias")
+                    return LogErrorP("Unknown argument attribute `%s`\n", current_token->value.c_str());
+                
+                is_noalias=true;
+                getNextToken(tok_id); // consume `noalias`
+            }
+
+            if(current_token->type!=tok_id)
+                return LogErrorP("Expected argument name after attributes");
+
             std::unique_ptr<VToken> var_name=copyCurrentToken();
             getNextToken(tok_id); // consume id
             if(current_token->type!=tok_colon) 
                 return LogErrorP("Expected ':' for type specifier after arg name");
             getNextToken(tok_colon); // consume colon
 
+            // `&Type` - argument is passed by reference instead of by value
+            bool is_reference=false;
+            if(current_token->type==tok_reference)
+            {
+                is_reference=true;
+                getNextToken(tok_reference); // consume '&'
+            }
+
             auto type=ParseTypeIdentifier();
-            auto var=std::make_unique<VariableDefAST>(std::move(var_name) , std::move(type), nullptr, true, false);
+            auto var=std::make_unique<VariableDefAST>(std::move(var_name) , type, nullptr, true, false);
+            var->isReference(is_reference);
+            var->isNoAlias(is_noalias);
             
             args.push_back(std::move(var));
 
@@ -707,7 +940,7 @@ namespace vire
 
         getNextToken(tok_rparen);
 
-        std::unique_ptr<types::Base> return_type;
+        types::Base* return_type;
         if(current_token->type==tok_colon || current_token->type==tok_returns)
         {
             getNextToken();
@@ -718,7 +951,11 @@ namespace vire
             return_type=types::construct(types::EType::Void);
         }
 
-        return std::make_unique<PrototypeAST>(std::move(fn_name), std::move(args), std::move(return_type));
+        auto attributes=ParseFunctionAttributes();
+
+        auto proto=std::make_unique<PrototypeAST>(std::move(fn_name), std::move(args), return_type);
+        proto->setAttributes(attributes);
+        return std::move(proto);
     }
     std::unique_ptr<PrototypeAST> VParser::ParseProto()
     {
@@ -904,7 +1141,7 @@ namespace vire
             getNextToken(tok_colon);
             
             auto type=ParseTypeIdentifier();
-            auto var=std::make_unique<VariableDefAST>(std::move(var_name), std::move(type), nullptr, true, false);
+            auto var=std::make_unique<VariableDefAST>(std::move(var_name), type, nullptr, true, false);
             args.push_back(std::move(var));
         }
         getNextToken(tok_rparen);
@@ -914,11 +1151,10 @@ namespace vire
         auto proto=std::make_unique<PrototypeAST>(VToken::construct("", tok_id), std::move(args), types::construct("void"), true, true);
         return std::make_unique<FunctionAST>(std::move(proto), std::move(block), true, true);
     }
-    std::pair<std::unordered_map<proto::IName, std::unique_ptr<ExprAST>>, std::unique_ptr<FunctionAST>> VParser::ParsePrimitiveBody()
+    PrimitiveBody VParser::ParsePrimitiveBody()
     {
         getNextToken(tok_lbrace);
-        std::unique_ptr<FunctionAST> constructor;
-        std::unordered_map<proto::IName, std::unique_ptr<ExprAST>> members;
+        PrimitiveBody body;
 
         bool found_constructor=false;
         while(current_token->type!=tok_rbrace)
@@ -953,7 +1189,7 @@ namespace vire
             {
                 auto cons=ParseConstructor();
                 if(found_constructor) std::cout << "Already encountered constructor, multiple constructors yet to be added" << std::endl;
-                else constructor=std::move(cons);
+                else body.constructor=std::move(cons);
                 continue;
             }
             else
@@ -962,12 +1198,13 @@ namespace vire
                 break;
             }
             
-            members.insert(std::make_pair(proto::IName(member_name), std::move(member)));
+            if(body.members.insert(std::make_pair(proto::IName(member_name), std::move(member))).second)
+                body.order.push_back(proto::IName(member_name));
         }
         
         getNextToken(tok_rbrace);
 
-        return std::make_pair(std::move(members), std::move(constructor));
+        return body;
     }
     std::unique_ptr<ExprAST> VParser::ParseUnion()
     {
@@ -983,7 +1220,9 @@ namespace vire
         }
 
         auto body=ParsePrimitiveBody();
-        return std::make_unique<UnionExprAST>(std::move(body.first), std::move(name));
+        auto union_=std::make_unique<UnionExprAST>(std::move(body.members), std::move(name));
+        union_->setMembersOrder(std::move(body.order));
+        return union_;
     }
     std::unique_ptr<ExprAST> VParser::ParseStruct()
     {
@@ -1000,9 +1239,9 @@ namespace vire
 
         auto body=ParsePrimitiveBody();
 
-        auto cons=std::move(body.second);
-        auto members=std::move(body.first);
-        return std::make_unique<StructExprAST>(std::move(members), std::move(cons), std::move(name));
+        auto struct_=std::make_unique<StructExprAST>(std::move(body.members), std::move(body.constructor), std::move(name));
+        struct_->setMembersOrder(std::move(body.order));
+        return struct_;
     }
 
     std::unique_ptr<ExprAST> VParser::ParseUnsafe()
@@ -1020,56 +1259,94 @@ namespace vire
         return std::make_unique<ReferenceExprAST>(std::move(var));
     }
 
+    // `import name;` - only at the top level of a module, `import` is not a reserved keyword
+    std::string VParser::ParseImport()
+    {
+        getNextToken(tok_id); // consume `import`
+
+        if(current_token->type!=tok_id)
+        {
+            LogError("Expected module name after `import`\n");
+            parse_success=false;
+            return "";
+        }
+
+        auto name=current_token->value;
+        getNextToken(tok_id);
+        getNextToken(tok_semicol);
+
+        return name;
+    }
     std::unique_ptr<ModuleAST> VParser::ParseSourceModule()
     {
         lexer->reset();
 
         getNextToken(true); // load the first token
         parse_success=true;
+        declarations.clear();
 
         std::vector<std::unique_ptr<ExprAST>> PreExecutionStatements;
         std::vector<std::unique_ptr<FunctionBaseAST>> Functions;
         std::vector<std::unique_ptr<ClassAST>> Classes;
         std::vector<std::unique_ptr<ExprAST>> StructUnionDefs;
-        while(current_token->type!=tok_eof)
+        std::vector<std::string> Imports;
+        std::size_t decl_begin=0;
+        while(current_token->type!=tok_eof && !isAtErrorLimit())
         {
-            if(current_token->type==tok_class)
+            DeclarationKind kind;
+            panicking=false;
+            auto stm_begin=lexer->getOffset();
+            if(current_token->type==tok_id && current_token->value=="import")
+            {
+                auto name=ParseImport();
+                if(!name.empty())
+                    Imports.push_back(name);
+                kind=decl_import;
+            }
+            else if(current_token->type==tok_class)
             {
                 auto class_ast=ParseClass();
                 Classes.push_back(std::move(class_ast));
+                kind=decl_class;
             }
             else if(current_token->type==tok_func)
             {
                 auto func_ast=ParseFunction();
                 Functions.push_back(std::move(func_ast));
+                kind=decl_function;
             }
             else if(current_token->type==tok_proto)
             {
                 auto proto_ast=ParseProto();
                 getNextToken(tok_semicol);
                 Functions.push_back(std::move(proto_ast));
+                kind=decl_function;
             }
             else if(current_token->type==tok_extern)
             {
                 auto extern_ast=ParseExtern();
                 getNextToken(tok_semicol);
                 Functions.push_back(std::move(extern_ast));
+                kind=decl_function;
             }
             else if(current_token->type==tok_struct)
             {
                 auto struct_ast=ParseStruct();
                 StructUnionDefs.push_back(std::move(struct_ast));
+                kind=decl_union_struct;
             }
             else if(current_token->type==tok_union)
             {
                 auto union_ast=ParseUnion();
                 StructUnionDefs.push_back(std::move(union_ast));
+                kind=decl_union_struct;
             }
             else
             {
                 auto stm=ParsePrimary();
 
-                if(stm->asttype!=ast_for 
+                if(stm
+                && stm->asttype!=ast_for 
                 && stm->asttype!=ast_while 
                 && stm->asttype!=ast_unsafe
                 && stm->asttype!=ast_if
@@ -1077,7 +1354,23 @@ namespace vire
                     getNextToken(tok_semicol);
                 
                 PreExecutionStatements.push_back(std::move(stm));
+                kind=decl_statement;
             }
+
+            // The module is not returned after an error, the rest is parsed for the errors in it
+            if(panicking)
+            {
+                if(lexer->getOffset()==stm_begin)
+                    getNextToken();
+
+                if(kind==decl_statement)
+                    synchronizeStatement();
+                else
+                    synchronizeDeclaration();
+            }
+
+            declarations.push_back({kind, decl_begin, prev_token_end, prev_token_line, prev_token_charpos});
+            decl_begin=prev_token_end;
         }
         
         if(!parse_success)
@@ -1085,6 +1378,16 @@ namespace vire
             return nullptr;
         }
 
-        return std::make_unique<ModuleAST>(std::move(PreExecutionStatements),std::move(Functions),std::move(Classes),std::move(StructUnionDefs));
+        auto mod=std::make_unique<ModuleAST>(std::move(PreExecutionStatements),std::move(Functions),std::move(Classes),std::move(StructUnionDefs));
+        for(auto const& name : Imports)
+        {
+            mod->addImport(name);
+        }
+
+        return mod;
+    }
+    std::vector<SourceDeclaration> const& VParser::getDeclarations() const
+    {
+        return declarations;
     }
 }
\ No newline at end of file
@@ -13,38 +13,80 @@
 namespace vire
 {
 
+enum DeclarationKind
+{
+    decl_import,
+    decl_function,
+    decl_union_struct,
+    decl_class,
+    decl_statement,
+};
+
+// SourceDeclaration - Span of a top-level declaration in the source, including the whitespace before it
+// `end_line` and `end_charpos` are the position of the lexer at `end`
+struct SourceDeclaration
+{
+    DeclarationKind kind;
+    std::size_t begin;
+    std::size_t end;
+    std::size_t end_line;
+    std::size_t end_charpos;
+};
+
+// PrimitiveBody - The body of a struct or union, `order` is the order the members were declared in
+struct PrimitiveBody
+{
+    std::unordered_map<proto::IName, std::unique_ptr<ExprAST>> members;
+    std::vector<proto::IName> order;
+    std::unique_ptr<FunctionAST> constructor;
+};
+
 class VParser
 {
     std::unique_ptr<VLexer> lexer;
     Config* config;
     bool parse_success;
+    bool panicking; // an error was reported in the current statement, the errors that follow from it are not
+    std::size_t prev_token_end;
+    std::size_t prev_token_line;
+    std::size_t prev_token_charpos;
+    std::vector<SourceDeclaration> declarations;
+
+    void reportError(const char* str, std::va_list args);
+    // Panic-mode recovery, the tokens up to the next statement or declaration are skipped
+    void synchronizeStatement();
+    void synchronizeDeclaration();
+    bool isDeclarationStart() const;
+    bool isAtErrorLimit() const;
 public:
     std::unique_ptr<VToken> current_token;
     const proto::IName* current_func_name;
 
     VParser(VLexer* _lexer, Config* _config=nullptr)
-    : lexer(_lexer), current_token() {
+    : lexer(_lexer), panicking(false), prev_token_end(0), current_token() {
         if(_config) config=_config;
         else config=lexer->getConfig();
     }
     VParser(std::unique_ptr<VLexer> _lexer, Config* _config=nullptr) 
-    : lexer(std::move(_lexer)), current_token(std::make_unique<VToken>("",tok_eof)) {
+    : lexer(std::move(_lexer)), panicking(false), prev_token_end(0), current_token(std::make_unique<VToken>("",tok_eof)) {
         if(_config) config=_config;
         else config=lexer->getConfig();
     }
+
+    VLexer* const getLexer() const { return lexer.get(); }
     
     std::unique_ptr<ExprAST> LogError(const char* str,...);
     std::unique_ptr<PrototypeAST> LogErrorP(const char* str,...);
     std::unique_ptr<FunctionAST> LogErrorF(const char* str,...);
     std::unique_ptr<ClassAST> LogErrorC(const char* str,...);
     std::vector<std::unique_ptr<ExprAST>> LogErrorVP(const char* str,...);
-    std::pair<std::unordered_map<proto::IName, std::unique_ptr<ExprAST>>, std::unique_ptr<FunctionAST>> LogErrorPB(const char* str,...);
+    PrimitiveBody LogErrorPB(const char* str,...);
 
     void getNextToken(bool first_token=false);
     void getNextToken(int toktype);
     std::unique_ptr<VToken> copyCurrentToken();
 
-    std::unique_ptr<types::Base> ParseTypeIdentifier();
+    types::Base* ParseTypeIdentifier();
     std::vector<std::unique_ptr<ExprAST>> ParseBlock();
 
     std::unique_ptr<ExprAST> ParsePrimary();
@@ -68,8 +110,11 @@ public:
 
     std::unique_ptr<ExprAST> ParseForExpr();
     std::unique_ptr<ExprAST> ParseWhileExpr();
+    std::unique_ptr<ExprAST> ParseLoopExpr();
+    LoopHints ParseLoopHints();
     std::unique_ptr<ExprAST> ParseBreakContinue();
 
+    unsigned int ParseFunctionAttributes();
     std::unique_ptr<PrototypeAST> ParsePrototype();
 
     std::unique_ptr<PrototypeAST> ParseProto();
@@ -85,14 +130,18 @@ public:
     std::unique_ptr<ExprAST> ParseClassAccess(std::unique_ptr<ExprAST> parent);
 
     std::unique_ptr<FunctionAST> ParseConstructor();
-    std::pair<std::unordered_map<proto::IName, std::unique_ptr<ExprAST>>, std::unique_ptr<FunctionAST>> ParsePrimitiveBody();
+    PrimitiveBody ParsePrimitiveBody();
     std::unique_ptr<ExprAST> ParseUnion();
     std::unique_ptr<ExprAST> ParseStruct();
 
     std::unique_ptr<ExprAST> ParseUnsafe();
     std::unique_ptr<ExprAST> ParseReference();
 
+    std::string ParseImport();
     std::unique_ptr<ModuleAST> ParseSourceModule();
+
+    // The top-level declarations of the last `ParseSourceModule` in source order
+    std::vector<SourceDeclaration> const& getDeclarations() const;
 };
 
 }
\ No newline at end of file
@@ -5,6 +5,13 @@
 
 #include "file.hpp"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace vire
 {
 namespace proto
@@ -36,12 +43,18 @@ namespace proto
 
     std::string readFile(std::fstream& file, char close)
     {
-        std::string buf, out;
+        // The rest of the file is read with one call into a buffer of its size
+        auto begin=file.tellg();
+        file.seekg(0, std::ios::end);
+        auto end=file.tellg();
+        file.seekg(begin);
 
-        while(std::getline(file,buf))
+        std::string out;
+        if(begin>=0 && end>begin)
         {
-            out += buf;
-            out += '\n';
+            out.resize(end-begin);
+            file.read(out.data(), out.size());
+            out.resize(file.gcount());
         }
 
         if(close)
@@ -50,5 +63,50 @@ namespace proto
         return out;
     }
 
+    MappedFile::MappedFile(std::string const& filename)
+    : data(nullptr), length(0), mapped(false)
+    {
+    #ifndef _WIN32
+        int fd=::open(filename.c_str(), O_RDONLY);
+        if(fd<0)
+            return;
+
+        struct stat st;
+        if(::fstat(fd, &st)==0 && st.st_size>0)
+        {
+            void* addr=::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(addr!=MAP_FAILED)
+            {
+                data=(const char*)addr;
+                length=st.st_size;
+                mapped=true;
+            }
+        }
+        ::close(fd);
+
+        if(mapped)
+            return;
+    #endif
+
+        // Empty files and platforms without mmap are read into memory
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if(!file.is_open())
+            return;
+
+        fallback.resize(file.tellg());
+        file.seekg(0);
+        file.read(fallback.data(), fallback.size());
+
+        data=fallback.data();
+        length=fallback.size();
+    }
+    MappedFile::~MappedFile()
+    {
+    #ifndef _WIN32
+        if(mapped)
+            ::munmap((void*)data, length);
+    #endif
+    }
+
 }
 }
\ No newline at end of file
@@ -13,7 +13,27 @@ namespace proto
 
     std::fstream openFile(const char* filename);
 
+    // Reads the file from its current position to the end
     std::string readFile(std::fstream& file, char close=0);
 
+    // MappedFile - Read-only view of a whole file, memory mapped where the platform supports it
+    class MappedFile
+    {
+        const char* data;
+        std::size_t length;
+        std::string fallback;
+        bool mapped;
+    public:
+        MappedFile(std::string const& filename);
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        bool isOpen() const { return data!=nullptr; }
+        const char* getData() const { return data; }
+        std::size_t getSize() const { return length; }
+    };
+
 }
 }
\ No newline at end of file
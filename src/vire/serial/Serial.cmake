@@ -0,0 +1,11 @@
+add_library(
+    vire-serial
+
+    ${SRC_DIR}/src/vire/serial/stream.hpp
+    ${SRC_DIR}/src/vire/serial/interface.hpp
+    ${SRC_DIR}/src/vire/serial/interface.cpp
+    ${SRC_DIR}/src/vire/serial/ast_cache.hpp
+    ${SRC_DIR}/src/vire/serial/ast_cache.cpp
+)
+
+target_link_libraries(VIRELANG PRIVATE vire-serial)
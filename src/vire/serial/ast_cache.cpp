@@ -0,0 +1,780 @@
+#include "ast_cache.hpp"
+#include "stream.hpp"
+
+#include "vire/proto/file.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <type_traits>
+
+namespace vire
+{
+namespace serial
+{
+    // Layout, integers are little endian and strings, tokens and types are written as in `stream.hpp`
+    //  header    u32 magic, u16 version, u64 source hash
+    //  expr      u8 asttype+1 (0 for null), then the fields of the node in constructor order
+    //  block     u32 count, exprs
+    //  function  u8 kind, prototype (name token, arg block, type return, u32 attributes, u8 flags), body block
+    //  module    header, u32 import count + strings, struct/union block, u32 function count + functions, statement block
+
+    enum FunctionKind : unsigned char
+    {
+        kind_function=0,
+        kind_proto=1,
+        kind_extern=2,
+    };
+    enum ProtoFlags : unsigned char
+    {
+        proto_selfref=1<<0,
+        proto_constructor=1<<1,
+    };
+    enum VarFlags : unsigned char
+    {
+        var_const=1<<0,
+        var_let=1<<1,
+        var_reference=1<<2,
+        var_noalias=1<<3,
+    };
+    enum HintFlags : unsigned char
+    {
+        hint_unroll_full=1<<0,
+        hint_unroll_disable=1<<1,
+        hint_vectorize_disable=1<<2,
+        hint_parallel=1<<3,
+    };
+
+    std::uint64_t hashSource(std::string_view source)
+    {
+        // FNV-1a, stable across runs and platforms unlike std::hash
+        std::uint64_t hash=0xcbf29ce484222325ull;
+        for(unsigned char c : source)
+        {
+            hash^=c;
+            hash*=0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    class ASTWriter
+    {
+        ByteWriter& out;
+        bool success;
+    public:
+        ASTWriter(ByteWriter& out) : out(out), success(true) {}
+
+        bool isSuccess() const { return success; }
+
+        void hints(LoopHints const& hints)
+        {
+            out.u32(hints.unroll_count);
+            out.u32(hints.vectorize_width);
+            out.u32(hints.interleave_count);
+
+            unsigned char flags=0;
+            if(hints.unroll_full)       flags|=hint_unroll_full;
+            if(hints.unroll_disable)    flags|=hint_unroll_disable;
+            if(hints.vectorize_disable) flags|=hint_vectorize_disable;
+            if(hints.parallel)          flags|=hint_parallel;
+            out.u8(flags);
+        }
+        template<typename T>
+        void block(std::vector<std::unique_ptr<T>> const& stms)
+        {
+            out.u32(stms.size());
+            for(auto const& stm : stms)
+                expr(stm.get());
+        }
+        void members(TypeAST* const type)
+        {
+            auto const& order=type->getMembersOrder();
+            out.u32(order.size());
+            for(auto const& iname : order)
+            {
+                out.str(iname.name);
+                expr(type->getMember(iname));
+            }
+        }
+        void prototype(PrototypeAST* const proto)
+        {
+            out.token(proto->getNameToken());
+            block(proto->getArgs());
+            out.type(proto->getReturnType());
+            out.u32(proto->getAttributes());
+
+            unsigned char flags=0;
+            if(proto->doesRequireSelfRef()) flags|=proto_selfref;
+            if(proto->isConstructor())      flags|=proto_constructor;
+            out.u8(flags);
+        }
+        void function(FunctionBaseAST* const func)
+        {
+            if(func->is_extern())
+            {
+                out.u8(kind_extern);
+                prototype(((ExternAST*)func)->getProto());
+            }
+            else if(func->is_proto())
+            {
+                out.u8(kind_proto);
+                prototype((PrototypeAST*)func);
+            }
+            else
+            {
+                out.u8(kind_function);
+                prototype(((FunctionAST*)func)->getProto());
+                block(((FunctionAST*)func)->getBody());
+            }
+        }
+
+        void expr(ExprAST* const expr)
+        {
+            if(!expr)
+            {
+                out.u8(0);
+                return;
+            }
+            out.u8(expr->asttype+1);
+
+            switch(expr->asttype)
+            {
+                case ast_int:
+                    out.token(expr->getToken());
+                    out.u32((unsigned int)((IntExprAST*)expr)->getValue());
+                    break;
+                case ast_float:
+                    out.token(expr->getToken());
+                    out.f32(((FloatExprAST*)expr)->getValue());
+                    break;
+                case ast_double:
+                    out.token(expr->getToken());
+                    out.f64(((DoubleExprAST*)expr)->getValue());
+                    break;
+                case ast_char:
+                    out.token(expr->getToken());
+                    out.u8(((CharExprAST*)expr)->getValue());
+                    break;
+                case ast_bool:
+                    out.token(expr->getToken());
+                    out.u8(((BoolExprAST*)expr)->getValue());
+                    break;
+                case ast_str:
+                    out.token(expr->getToken());
+                    out.str(((StrExprAST*)expr)->getValue());
+                    break;
+                case ast_array:
+                {
+                    // The parser widens the literal to the length of the declared array
+                    auto* arr=(ArrayExprAST*)expr;
+                    block(arr->getElements());
+                    out.u32(((types::Array*)arr->getType())->getLength());
+                    break;
+                }
+
+                case ast_unop:
+                {
+                    auto* unop=(UnaryExprAST*)expr;
+                    out.token(unop->getop());
+                    this->expr(unop->getExpr());
+                    break;
+                }
+                case ast_binop:
+                {
+                    auto* binop=(BinaryExprAST*)expr;
+                    out.token(binop->getOp());
+                    this->expr(binop->getLHS());
+                    this->expr(binop->getRHS());
+                    break;
+                }
+                case ast_incrdecr:
+                {
+                    auto* incrdecr=(IncrementDecrementAST*)expr;
+                    this->expr(incrdecr->getExpr());
+                    out.u8(incrdecr->isPre());
+                    out.u8(incrdecr->isIncrement());
+                    break;
+                }
+
+                case ast_var:
+                    out.token(expr->getToken());
+                    break;
+                case ast_type_access:
+                {
+                    auto* access=(TypeAccessAST*)expr;
+                    this->expr(access->getParent());
+                    this->expr(access->getChild());
+                    break;
+                }
+                case ast_array_access:
+                {
+                    auto* access=(VariableArrayAccessAST*)expr;
+                    this->expr(access->getExpr());
+                    block(access->getIndices());
+                    break;
+                }
+                case ast_varassign:
+                {
+                    auto* assign=(VariableAssignAST*)expr;
+                    this->expr(assign->getLHS());
+                    this->expr(assign->getRHS());
+                    out.token(assign->getShorthandOperator());
+                    break;
+                }
+                case ast_vardef:
+                {
+                    // The declared type, `getType` falls back to the type of the value
+                    auto* var=(VariableDefAST*)expr;
+                    auto* type=var->ExprAST::getType();
+
+                    out.token(var->getToken());
+                    out.u8(type!=nullptr);
+                    if(type) out.type(type);
+                    this->expr(var->getValue());
+
+                    unsigned char flags=0;
+                    if(var->isConst())      flags|=var_const;
+                    if(var->isLet())        flags|=var_let;
+                    if(var->isReference())  flags|=var_reference;
+                    if(var->isNoAlias())    flags|=var_noalias;
+                    out.u8(flags);
+                    break;
+                }
+                case ast_cast:
+                {
+                    auto* cast=(CastExprAST*)expr;
+                    this->expr(cast->getExpr());
+                    out.type(cast->getDestType());
+                    out.u8(cast->isNonUserDefined());
+                    break;
+                }
+                case ast_call:
+                {
+                    auto* call=(CallExprAST*)expr;
+                    out.token(call->getToken());
+                    block(call->getArgs());
+                    break;
+                }
+                case ast_return:
+                {
+                    auto* ret=(ReturnExprAST*)expr;
+                    this->expr(ret->getValue());
+                    out.str(ret->getIName().name);
+                    break;
+                }
+
+                case ast_if:
+                {
+                    auto* ifthen=(IfThenExpr*)expr;
+                    this->expr(ifthen->getCondition());
+                    block(ifthen->getThenBlock());
+                    break;
+                }
+                case ast_ifelse:
+                {
+                    auto* ifelse=(IfExprAST*)expr;
+                    this->expr(ifelse->getIfThen());
+                    block(ifelse->getElifLadder());
+                    break;
+                }
+                case ast_for:
+                {
+                    auto* loop=(ForExprAST*)expr;
+                    this->expr(loop->getInit());
+                    this->expr(loop->getCond());
+                    this->expr(loop->getIncr());
+                    block(loop->getBody());
+                    hints(loop->getHints());
+                    break;
+                }
+                case ast_while:
+                {
+                    auto* loop=(WhileExprAST*)expr;
+                    this->expr(loop->getCond());
+                    block(loop->getBody());
+                    hints(loop->getHints());
+                    break;
+                }
+                case ast_break:
+                {
+                    auto* brk=(BreakExprAST*)expr;
+                    this->expr(brk->is_after ? brk->getAfterBreak() : nullptr);
+                    break;
+                }
+                case ast_continue:
+                {
+                    auto* cont=(ContinueExprAST*)expr;
+                    this->expr(cont->is_after ? cont->getAfterCont() : nullptr);
+                    break;
+                }
+
+                case ast_unsafe:
+                    block(((UnsafeExprAST*)expr)->getBody());
+                    break;
+                case ast_reference:
+                    this->expr(((ReferenceExprAST*)expr)->getVariable());
+                    break;
+
+                case ast_struct:
+                {
+                    auto* st=(StructExprAST*)expr;
+                    out.str(st->getIName().name);
+                    members(st);
+
+                    out.u8(st->getConstructor()!=nullptr);
+                    if(st->getConstructor())
+                        function(st->getConstructor());
+                    break;
+                }
+                case ast_union:
+                {
+                    auto* un=(UnionExprAST*)expr;
+                    out.str(un->getIName().name);
+                    members(un);
+                    break;
+                }
+
+                default:
+                    // Classes, `new` and `delete` are not cached
+                    success=false;
+                    break;
+            }
+        }
+    };
+
+    class ASTReader
+    {
+        ByteReader& in;
+    public:
+        ASTReader(ByteReader& in) : in(in) {}
+
+        LoopHints hints()
+        {
+            LoopHints hints;
+            hints.unroll_count=in.u32();
+            hints.vectorize_width=in.u32();
+            hints.interleave_count=in.u32();
+
+            auto flags=in.u8();
+            hints.unroll_full=flags & hint_unroll_full;
+            hints.unroll_disable=flags & hint_unroll_disable;
+            hints.vectorize_disable=flags & hint_vectorize_disable;
+            hints.parallel=flags & hint_parallel;
+            return hints;
+        }
+        // Constructors of the AST dereference their tokens, a missing one means the cache is corrupt
+        std::unique_ptr<VToken> requiredToken()
+        {
+            auto tok=in.token();
+            if(!tok)
+            {
+                in.fail();
+                tok=VToken::construct("");
+            }
+            return tok;
+        }
+        template<typename T>
+        std::unique_ptr<T> requiredExpr(int type)
+        {
+            auto expr=this->expr();
+            if(!expr || expr->asttype!=type)
+            {
+                in.fail();
+                return nullptr;
+            }
+            return cast_static<T>(std::move(expr));
+        }
+        template<typename T=ExprAST>
+        std::vector<std::unique_ptr<T>> block(int type=-1)
+        {
+            std::vector<std::unique_ptr<T>> stms;
+            auto count=in.u32();
+            for(unsigned int i=0; i<count && !in.isFailed(); i++)
+            {
+                if constexpr(std::is_same_v<T, ExprAST>)
+                    stms.push_back(expr());
+                else
+                    stms.push_back(requiredExpr<T>(type));
+            }
+            return stms;
+        }
+        INameExprMap members(std::vector<proto::IName>& order)
+        {
+            INameExprMap members;
+            auto count=in.u32();
+            for(unsigned int i=0; i<count && !in.isFailed(); i++)
+            {
+                auto name=proto::IName(in.str());
+                auto member=expr();
+                if(!member)
+                {
+                    in.fail();
+                    break;
+                }
+
+                order.push_back(name);
+                members.insert(std::make_pair(name, std::move(member)));
+            }
+            return members;
+        }
+        std::unique_ptr<PrototypeAST> prototype()
+        {
+            auto name=requiredToken();
+            auto args=block<VariableDefAST>(ast_vardef);
+            auto return_type=in.type();
+            auto attributes=in.u32();
+            auto flags=in.u8();
+
+            auto proto=std::make_unique<PrototypeAST>(std::move(name), std::move(args), return_type,
+                flags & proto_selfref, flags & proto_constructor);
+            proto->setAttributes(attributes);
+            return proto;
+        }
+        std::unique_ptr<FunctionBaseAST> function()
+        {
+            auto kind=in.u8();
+            auto proto=prototype();
+            switch(kind)
+            {
+                case kind_extern:
+                    return std::make_unique<ExternAST>(std::move(proto));
+                case kind_proto:
+                    return std::move(proto);
+                case kind_function:
+                {
+                    bool selfref=proto->doesRequireSelfRef(), constructor=proto->isConstructor();
+                    return std::make_unique<FunctionAST>(std::move(proto), block(), selfref, constructor);
+                }
+                default:
+                    in.fail();
+                    return nullptr;
+            }
+        }
+
+        std::unique_ptr<ExprAST> expr()
+        {
+            auto tag=in.u8();
+            if(tag==0 || in.isFailed())
+                return nullptr;
+
+            switch(tag-1)
+            {
+                case ast_int:
+                {
+                    auto tok=in.token();
+                    return std::make_unique<IntExprAST>((int)in.u32(), std::move(tok));
+                }
+                case ast_float:
+                {
+                    auto tok=in.token();
+                    return std::make_unique<FloatExprAST>(in.f32(), std::move(tok));
+                }
+                case ast_double:
+                {
+                    auto tok=in.token();
+                    return std::make_unique<DoubleExprAST>(in.f64(), std::move(tok));
+                }
+                case ast_char:
+                {
+                    auto tok=in.token();
+                    return std::make_unique<CharExprAST>((char)in.u8(), std::move(tok));
+                }
+                case ast_bool:
+                {
+                    auto tok=in.token();
+                    return std::make_unique<BoolExprAST>(in.u8()!=0, std::move(tok));
+                }
+                case ast_str:
+                {
+                    auto tok=in.token();
+                    return std::make_unique<StrExprAST>(in.str(), std::move(tok));
+                }
+                case ast_array:
+                {
+                    auto arr=std::make_unique<ArrayExprAST>(block());
+                    arr->setType(types::getArray(((types::Array*)arr->getType())->getChild(), in.u32()));
+                    return arr;
+                }
+
+                case ast_unop:
+                {
+                    auto op=requiredToken();
+                    return std::make_unique<UnaryExprAST>(std::move(op), expr());
+                }
+                case ast_binop:
+                {
+                    auto op=requiredToken();
+                    auto lhs=expr();
+                    auto rhs=expr();
+                    return std::make_unique<BinaryExprAST>(std::move(op), std::move(lhs), std::move(rhs));
+                }
+                case ast_incrdecr:
+                {
+                    auto operand=expr();
+                    bool is_pre=in.u8();
+                    bool is_increment=in.u8();
+                    return std::make_unique<IncrementDecrementAST>(std::move(operand), is_pre, is_increment);
+                }
+
+                case ast_var:
+                    return std::make_unique<VariableExprAST>(requiredToken());
+                case ast_type_access:
+                {
+                    auto parent=expr();
+                    auto child=expr();
+                    if(!child)
+                    {
+                        in.fail();
+                        return nullptr;
+                    }
+                    return std::make_unique<TypeAccessAST>(std::move(parent), cast_static<IdentifierExprAST>(std::move(child)));
+                }
+                case ast_array_access:
+                {
+                    auto array=expr();
+                    return std::make_unique<VariableArrayAccessAST>(std::move(array), block());
+                }
+                case ast_varassign:
+                {
+                    auto lhs=expr();
+                    auto rhs=expr();
+                    return std::make_unique<VariableAssignAST>(std::move(lhs), std::move(rhs), in.token());
+                }
+                case ast_vardef:
+                {
+                    auto name=requiredToken();
+                    types::Base* type=nullptr;
+                    if(in.u8())
+                        type=in.type();
+                    auto value=expr();
+                    auto flags=in.u8();
+
+                    auto var=std::make_unique<VariableDefAST>(std::move(name), type, std::move(value), flags & var_const, flags & var_let);
+                    var->isReference(flags & var_reference);
+                    var->isNoAlias(flags & var_noalias);
+                    return var;
+                }
+                case ast_cast:
+                {
+                    auto operand=expr();
+                    auto type=in.type();
+                    bool is_non_user_defined=in.u8();
+                    return std::make_unique<CastExprAST>(std::move(operand), type, is_non_user_defined);
+                }
+                case ast_call:
+                {
+                    auto callee=requiredToken();
+                    return std::make_unique<CallExprAST>(std::move(callee), block());
+                }
+                case ast_return:
+                {
+                    auto ret=std::make_unique<ReturnExprAST>(expr());
+                    ret->setName(in.str());
+                    return ret;
+                }
+
+                case ast_if:
+                {
+                    auto cond=expr();
+                    return std::make_unique<IfThenExpr>(std::move(cond), block());
+                }
+                case ast_ifelse:
+                {
+                    auto ifthen=requiredExpr<IfThenExpr>(ast_if);
+                    return std::make_unique<IfExprAST>(std::move(ifthen), block<IfThenExpr>(ast_if));
+                }
+                case ast_for:
+                {
+                    auto init=expr();
+                    auto cond=expr();
+                    auto incr=expr();
+                    auto loop=std::make_unique<ForExprAST>(std::move(init), std::move(cond), std::move(incr), block());
+                    loop->setHints(hints());
+                    return loop;
+                }
+                case ast_while:
+                {
+                    auto cond=expr();
+                    auto loop=std::make_unique<WhileExprAST>(std::move(cond), block());
+                    loop->setHints(hints());
+                    return loop;
+                }
+                case ast_break:
+                {
+                    auto after=expr();
+                    return after ? std::make_unique<BreakExprAST>(std::move(after)) : std::make_unique<BreakExprAST>();
+                }
+                case ast_continue:
+                {
+                    auto after=expr();
+                    return after ? std::make_unique<ContinueExprAST>(std::move(after)) : std::make_unique<ContinueExprAST>();
+                }
+
+                case ast_unsafe:
+                    return std::make_unique<UnsafeExprAST>(block());
+                case ast_reference:
+                    return std::make_unique<ReferenceExprAST>(expr());
+
+                case ast_struct:
+                {
+                    auto name=in.str();
+                    std::vector<proto::IName> order;
+                    auto members=this->members(order);
+
+                    std::unique_ptr<FunctionAST> constructor;
+                    if(in.u8())
+                    {
+                        auto func=function();
+                        if(!func || func->is_proto() || func->is_extern())
+                        {
+                            in.fail();
+                            return nullptr;
+                        }
+                        constructor.reset((FunctionAST*)func.release());
+                    }
+
+                    auto st=std::make_unique<StructExprAST>(std::move(members), std::move(constructor), VToken::construct(name, tok_id));
+                    st->setMembersOrder(std::move(order));
+                    return st;
+                }
+                case ast_union:
+                {
+                    auto name=in.str();
+                    std::vector<proto::IName> order;
+                    auto members=this->members(order);
+
+                    auto un=std::make_unique<UnionExprAST>(std::move(members), VToken::construct(name, tok_id));
+                    un->setMembersOrder(std::move(order));
+                    return un;
+                }
+
+                default:
+                    in.fail();
+                    return nullptr;
+            }
+        }
+    };
+
+    bool writeASTCache(ModuleAST* const mod, std::string_view source, std::string const& path)
+    {
+        if(!mod->getClasses().empty())
+            return false;
+
+        ByteWriter out;
+        ASTWriter writer(out);
+
+        out.u32(ast_cache_magic);
+        out.u16(ast_cache_version);
+        out.u64(hashSource(source));
+
+        out.u32(mod->getImports().size());
+        for(auto const& name : mod->getImports())
+        {
+            out.str(name);
+        }
+
+        writer.block(mod->getUnionStructs());
+
+        out.u32(mod->getFunctions().size());
+        for(auto const& func : mod->getFunctions())
+        {
+            writer.function(func.get());
+        }
+
+        writer.block(mod->getPreExecutionStatements());
+
+        if(!writer.isSuccess())
+            return false;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+        {
+            std::cout << "Could not write the AST cache `" << path << "`" << std::endl;
+            return false;
+        }
+
+        auto const& buffer=out.getBuffer();
+        file.write(buffer.data(), buffer.size());
+        return file.good();
+    }
+
+    std::unique_ptr<ModuleAST> readASTCache(std::string const& path, std::string_view source)
+    {
+        // The cache is decoded straight from the mapped file, nothing is copied before the AST is built
+        proto::MappedFile file(path);
+        if(!file.isOpen())
+            return nullptr;
+
+        ByteReader in(file.getData(), file.getSize());
+        if(in.u32()!=ast_cache_magic || in.u16()!=ast_cache_version || in.u64()!=hashSource(source))
+            return nullptr;
+
+        ASTReader reader(in);
+
+        std::vector<std::string> imports;
+        auto import_count=in.u32();
+        for(unsigned int i=0; i<import_count && !in.isFailed(); i++)
+        {
+            imports.push_back(in.str());
+        }
+
+        auto union_structs=reader.block();
+
+        std::vector<std::unique_ptr<FunctionBaseAST>> funcs;
+        auto func_count=in.u32();
+        for(unsigned int i=0; i<func_count && !in.isFailed(); i++)
+        {
+            funcs.push_back(reader.function());
+        }
+
+        auto stms=reader.block();
+
+        if(in.isFailed())
+        {
+            std::cout << "The AST cache `" << path << "` is corrupt, parsing the source instead" << std::endl;
+            return nullptr;
+        }
+
+        auto mod=std::make_unique<ModuleAST>(std::move(stms), std::move(funcs), std::vector<std::unique_ptr<ClassAST>>(), std::move(union_structs));
+        for(auto const& name : imports)
+        {
+            mod->addImport(name);
+        }
+        return mod;
+    }
+
+    std::string writeDeclaration(ExprAST* const expr)
+    {
+        ByteWriter out;
+        ASTWriter writer(out);
+        writer.expr(expr);
+        return writer.isSuccess() ? out.getBuffer() : "";
+    }
+    std::string writeDeclaration(FunctionBaseAST* const func)
+    {
+        ByteWriter out;
+        ASTWriter writer(out);
+        writer.function(func);
+        return writer.isSuccess() ? out.getBuffer() : "";
+    }
+
+    std::unique_ptr<ExprAST> readExprDeclaration(std::string const& data, long line_shift)
+    {
+        ByteReader in(data.data(), data.size());
+        in.setLineShift(line_shift);
+
+        ASTReader reader(in);
+        auto expr=reader.expr();
+        return in.isFailed() ? nullptr : std::move(expr);
+    }
+    std::unique_ptr<FunctionBaseAST> readFunctionDeclaration(std::string const& data, long line_shift)
+    {
+        ByteReader in(data.data(), data.size());
+        in.setLineShift(line_shift);
+
+        ASTReader reader(in);
+        auto func=reader.function();
+        return in.isFailed() ? nullptr : std::move(func);
+    }
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vire/ast/include.hpp"
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+
+namespace vire
+{
+namespace serial
+{
+    // AST cache files (`.vast`) - the parsed module of a source in a compact binary form
+    // Loading one skips lexing and parsing, it is only used while the source hashes to the same value
+
+    constexpr unsigned int ast_cache_magic=0x54534156; // "VAST"
+    constexpr unsigned short ast_cache_version=1;
+
+    std::uint64_t hashSource(std::string_view source);
+
+    // Writes the parsed, not yet verified, `mod` of `source` to `path`
+    // Modules with classes are not cached, false is returned for them
+    bool writeASTCache(ModuleAST* const mod, std::string_view source, std::string const& path);
+
+    // Reads the module cached at `path`, nullptr when there is no cache for this exact `source`
+    std::unique_ptr<ModuleAST> readASTCache(std::string const& path, std::string_view source);
+
+    // Single top-level declarations in the same form, kept in memory by the incremental parser
+    // An empty string is returned for the declarations that can not be written
+    std::string writeDeclaration(ExprAST* const expr);
+    std::string writeDeclaration(FunctionBaseAST* const func);
+    // The tokens of the declaration are moved by `line_shift` lines, nullptr is returned for broken data
+    std::unique_ptr<ExprAST> readExprDeclaration(std::string const& data, long line_shift);
+    std::unique_ptr<FunctionBaseAST> readFunctionDeclaration(std::string const& data, long line_shift);
+}
+}
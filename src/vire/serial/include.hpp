@@ -0,0 +1,4 @@
+#pragma once
+
+#include "interface.hpp"
+#include "ast_cache.hpp"
\ No newline at end of file
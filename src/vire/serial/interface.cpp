@@ -0,0 +1,257 @@
+#include "interface.hpp"
+#include "stream.hpp"
+
+#include "vire/proto/file.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+namespace vire
+{
+namespace serial
+{
+    // Layout, all integers are little endian
+    //  header    u32 magic, u16 version
+    //  string    u32 length, bytes
+    //  type      u8 EType, Array: u32 length + child type, Custom/Void: string name
+    //  struct    string name, u64 size, u32 constructor arg count + (string name, type) each,
+    //            u32 member count + (u8 kind, string name, type or nested struct) each in layout order
+    //  function  string name, u32 attributes, type return, u32 arg count + (string name, u8 flags, type) each
+    //  module    header, u32 struct count + structs, u32 function count + functions
+
+    enum MemberKind : unsigned char
+    {
+        member_var=0,
+        member_struct=1,
+    };
+    enum ArgFlags : unsigned char
+    {
+        arg_reference=1<<0,
+        arg_noalias=1<<1,
+    };
+
+    static void writeStructMembers(ByteWriter& out, StructExprAST* const st)
+    {
+        auto const& order=st->getMembersOrder();
+        out.u32(order.size());
+        for(auto const& iname : order)
+        {
+            auto* member=st->getMember(iname);
+            if(member->asttype==ast_struct)
+            {
+                out.u8(member_struct);
+                out.str(iname.name);
+                writeStructMembers(out, (StructExprAST*)member);
+            }
+            else
+            {
+                out.u8(member_var);
+                out.str(iname.name);
+                out.type(member->getType());
+            }
+        }
+    }
+    static void writeStruct(ByteWriter& out, StructExprAST* const st)
+    {
+        out.str(st->getIName().name);
+
+        auto size=types::custom_type_sizes.find(st->getName());
+        out.u64(size!=types::custom_type_sizes.end() ? size->second : 0);
+
+        // `self` is added to the constructor by the analyzer, it is added again on import
+        auto const& args=st->getConstructor()->getArgs();
+        std::size_t first=st->getConstructor()->doesRequireSelfRef() ? 1 : 0;
+        out.u32(args.size()-first);
+        for(std::size_t i=first; i<args.size(); i++)
+        {
+            out.str(args[i]->getIName().name);
+            out.type(args[i]->getType());
+        }
+
+        writeStructMembers(out, st);
+    }
+    static void writeFunction(ByteWriter& out, FunctionAST* const func)
+    {
+        auto* proto=func->getProto();
+        out.str(proto->getIName().name);
+        out.u32(proto->getAttributes());
+        out.type(proto->getReturnType());
+
+        auto const& args=proto->getArgs();
+        out.u32(args.size());
+        for(auto const& arg : args)
+        {
+            unsigned char flags=0;
+            if(arg->isReference())  flags|=arg_reference;
+            if(arg->isNoAlias())    flags|=arg_noalias;
+
+            out.str(arg->getIName().name);
+            out.u8(flags);
+            out.type(arg->getType());
+        }
+    }
+
+    bool writeInterface(ModuleAST* const mod, std::string const& path)
+    {
+        ByteWriter out;
+        out.u32(interface_magic);
+        out.u16(interface_version);
+
+        // Structs of other modules are exported by the interface of their own module
+        std::vector<StructExprAST*> structs;
+        for(auto const& s : mod->getUnionStructs())
+        {
+            if(s->asttype==ast_struct && !((StructExprAST*)s.get())->isImported())
+                structs.push_back((StructExprAST*)s.get());
+        }
+        out.u32(structs.size());
+        for(auto* st : structs)
+        {
+            writeStruct(out, st);
+        }
+
+        // Only functions defined in this module, outlined functions (`name.suffix`) and `main` stay private
+        std::vector<FunctionAST*> funcs;
+        for(auto const& f : mod->getFunctions())
+        {
+            if(f->is_proto() || f->is_extern())
+                continue;
+
+            auto const& name=f->getIName().name;
+            if(name=="main" || name.find('.')!=std::string::npos)
+                continue;
+
+            funcs.push_back((FunctionAST*)f.get());
+        }
+        out.u32(funcs.size());
+        for(auto* func : funcs)
+        {
+            writeFunction(out, func);
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+        {
+            std::cout << "Could not write the interface file `" << path << "`" << std::endl;
+            return false;
+        }
+
+        auto const& buffer=out.getBuffer();
+        file.write(buffer.data(), buffer.size());
+        return file.good();
+    }
+
+    static std::unique_ptr<StructExprAST> readStructMembers(ByteReader& in, std::string const& name)
+    {
+        INameExprMap members;
+        std::vector<proto::IName> order;
+
+        auto count=in.u32();
+        for(unsigned int i=0; i<count && !in.isFailed(); i++)
+        {
+            auto kind=in.u8();
+            auto member_name=in.str();
+
+            std::unique_ptr<ExprAST> member;
+            if(kind==member_struct)
+                member=readStructMembers(in, member_name);
+            else
+                member=std::make_unique<VariableDefAST>(VToken::construct(member_name, tok_id), in.type(), nullptr);
+
+            order.push_back(proto::IName(member_name));
+            members.insert(std::make_pair(proto::IName(member_name), std::move(member)));
+        }
+
+        auto st=std::make_unique<StructExprAST>(std::move(members), nullptr, VToken::construct(name, tok_id));
+        st->setMembersOrder(std::move(order));
+        st->isImported(true);
+        return st;
+    }
+    static std::unique_ptr<StructExprAST> readStruct(ByteReader& in, std::unordered_map<std::string, std::uint64_t>& type_sizes)
+    {
+        auto name=in.str();
+        auto size=in.u64();
+
+        // The constructor is only declared, like the one `ParseConstructor` creates but without a body
+        std::vector<std::unique_ptr<VariableDefAST>> args;
+        auto arg_count=in.u32();
+        for(unsigned int i=0; i<arg_count && !in.isFailed(); i++)
+        {
+            auto arg_name=in.str();
+            args.push_back(std::make_unique<VariableDefAST>(VToken::construct(arg_name, tok_id), in.type(), nullptr, true, false));
+        }
+        auto proto=std::make_unique<PrototypeAST>(VToken::construct("", tok_id), std::move(args), types::construct("void"), true, true);
+        auto constructor=std::make_unique<FunctionAST>(std::move(proto), std::vector<std::unique_ptr<ExprAST>>(), true, true);
+
+        auto st=readStructMembers(in, name);
+        st->setConstructor(std::move(constructor));
+
+        type_sizes[st->getName()]=size;
+        return st;
+    }
+    static std::unique_ptr<PrototypeAST> readFunction(ByteReader& in)
+    {
+        auto name=in.str();
+        auto attributes=in.u32();
+        auto return_type=in.type();
+
+        std::vector<std::unique_ptr<VariableDefAST>> args;
+        auto arg_count=in.u32();
+        for(unsigned int i=0; i<arg_count && !in.isFailed(); i++)
+        {
+            auto arg_name=in.str();
+            auto flags=in.u8();
+
+            auto arg=std::make_unique<VariableDefAST>(VToken::construct(arg_name, tok_id), in.type(), nullptr, true, false);
+            arg->isReference(flags & arg_reference);
+            arg->isNoAlias(flags & arg_noalias);
+            args.push_back(std::move(arg));
+        }
+
+        auto proto=std::make_unique<PrototypeAST>(VToken::construct(name, tok_id), std::move(args), return_type);
+        proto->setAttributes(attributes);
+        return proto;
+    }
+
+    std::unique_ptr<ModuleAST> readInterface(std::string const& path, std::unordered_map<std::string, std::uint64_t>& type_sizes)
+    {
+        proto::MappedFile file(path);
+        if(!file.isOpen())
+        {
+            std::cout << "Could not open the interface file `" << path << "`" << std::endl;
+            return nullptr;
+        }
+
+        ByteReader in(file.getData(), file.getSize());
+        if(in.u32()!=interface_magic || in.u16()!=interface_version)
+        {
+            std::cout << "`" << path << "` is not an interface file of this compiler version" << std::endl;
+            return nullptr;
+        }
+
+        std::vector<std::unique_ptr<ExprAST>> structs;
+        auto struct_count=in.u32();
+        for(unsigned int i=0; i<struct_count && !in.isFailed(); i++)
+        {
+            structs.push_back(readStruct(in, type_sizes));
+        }
+
+        std::vector<std::unique_ptr<FunctionBaseAST>> funcs;
+        auto func_count=in.u32();
+        for(unsigned int i=0; i<func_count && !in.isFailed(); i++)
+        {
+            funcs.push_back(readFunction(in));
+        }
+
+        if(in.isFailed())
+        {
+            std::cout << "The interface file `" << path << "` is truncated" << std::endl;
+            return nullptr;
+        }
+
+        return std::make_unique<ModuleAST>(std::vector<std::unique_ptr<ExprAST>>(), std::move(funcs),
+            std::vector<std::unique_ptr<ClassAST>>(), std::move(structs));
+    }
+}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "vire/ast/include.hpp"
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+namespace vire
+{
+namespace serial
+{
+    // Module interface files (`.vi`) - the exported declarations of a verified module in a compact binary form
+    // An importing module loads them instead of parsing and verifying the source of its dependency again
+
+    constexpr unsigned int interface_magic=0x49455256; // "VREI"
+    constexpr unsigned short interface_version=3; // 3 - struct members are laid out in declaration order
+
+    // Writes the functions and structs of `mod` to `path`, the module has to be verified
+    bool writeInterface(ModuleAST* const mod, std::string const& path);
+
+    // Reads the interface at `path` as a module of prototypes and imported structs
+    // The recorded sizes of the structs are added to `type_sizes` to detect stale interfaces after verification
+    std::unique_ptr<ModuleAST> readInterface(std::string const& path, std::unordered_map<std::string, std::uint64_t>& type_sizes);
+}
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "vire/ast/include.hpp"
+
+#include <string>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+
+namespace vire
+{
+namespace serial
+{
+
+// ByteWriter - Appends little endian integers, strings, tokens and types to a buffer
+class ByteWriter
+{
+    std::string buffer;
+public:
+    void u8(unsigned char value)
+    {
+        buffer.push_back((char)value);
+    }
+    void u16(unsigned short value)
+    {
+        for(int i=0; i<2; i++)  u8((value>>(i*8)) & 0xff);
+    }
+    void u32(unsigned int value)
+    {
+        for(int i=0; i<4; i++)  u8((value>>(i*8)) & 0xff);
+    }
+    void u64(std::uint64_t value)
+    {
+        for(int i=0; i<8; i++)  u8((value>>(i*8)) & 0xff);
+    }
+    void f32(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    }
+    void f64(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u64(bits);
+    }
+    void str(std::string const& value)
+    {
+        u32(value.size());
+        buffer+=value;
+    }
+    // Tokens keep their position for the diagnostics of the analyzer
+    void token(VToken* const tok)
+    {
+        u8(tok!=nullptr);
+        if(!tok)
+            return;
+
+        u32((unsigned int)tok->type);
+        str(tok->value);
+        u32(tok->line);
+        u32(tok->charpos);
+    }
+    void type(types::Base* const ty)
+    {
+        u8((unsigned char)ty->getType());
+        switch(ty->getType())
+        {
+            case types::EType::Array:
+            {
+                auto* arr=(types::Array*)ty;
+                u32(arr->getLength());
+                type(arr->getChild());
+                break;
+            }
+            case types::EType::Custom:
+                str(((types::Custom*)ty)->getName());
+                break;
+            case types::EType::Void:
+                str(((types::Void*)ty)->getName());
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::string const& getBuffer() const { return buffer; }
+};
+
+// ByteReader - Reads what `ByteWriter` wrote from a buffer it does not own, reading past the end sets `failed`
+class ByteReader
+{
+    const char* data;
+    std::size_t size;
+    std::size_t pos;
+    bool failed;
+    long line_shift;
+public:
+    ByteReader(const char* data, std::size_t size) : data(data), size(size), pos(0), failed(false), line_shift(0) {}
+
+    unsigned char u8()
+    {
+        if(pos>=size)
+        {
+            failed=true;
+            return 0;
+        }
+        return (unsigned char)data[pos++];
+    }
+    unsigned short u16()
+    {
+        unsigned short value=0;
+        for(int i=0; i<2; i++)  value|=(unsigned short)u8()<<(i*8);
+        return value;
+    }
+    unsigned int u32()
+    {
+        unsigned int value=0;
+        for(int i=0; i<4; i++)  value|=(unsigned int)u8()<<(i*8);
+        return value;
+    }
+    std::uint64_t u64()
+    {
+        std::uint64_t value=0;
+        for(int i=0; i<8; i++)  value|=(std::uint64_t)u8()<<(i*8);
+        return value;
+    }
+    float f32()
+    {
+        std::uint32_t bits=u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    double f64()
+    {
+        std::uint64_t bits=u64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    std::string str()
+    {
+        auto len=u32();
+        if(failed || len>size-pos)
+        {
+            failed=true;
+            return "";
+        }
+
+        std::string value(data+pos, len);
+        pos+=len;
+        return value;
+    }
+    std::unique_ptr<VToken> token()
+    {
+        if(!u8())
+            return nullptr;
+
+        int type=(int)u32();
+        auto value=str();
+        std::size_t line=u32()+line_shift;
+        std::size_t charpos=u32();
+        return VToken::construct(value, type, line, charpos);
+    }
+    // Types are rebuilt the way the parser creates them, the analyzer resolves the struct names again
+    types::Base* type()
+    {
+        auto ety=(types::EType)u8();
+        switch(ety)
+        {
+            case types::EType::Array:
+            {
+                auto len=u32();
+                auto child=type();
+                return types::getArray(child, len);
+            }
+            case types::EType::Custom:
+            case types::EType::Void:
+                return types::getNamedVoid(str());
+            default:
+                if(ety>types::EType::Any) failed=true;
+                return types::construct(ety);
+        }
+    }
+
+    // Moves the tokens that are read by `shift` lines, for code that moved in the source since it was written
+    void setLineShift(long shift) { line_shift=shift; }
+
+    void fail() { failed=true; }
+    bool isFailed() const { return failed; }
+};
+
+}
+}
@@ -5,6 +5,8 @@
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <functional>
+#include <unordered_set>
 
 namespace vire
 {
@@ -235,7 +237,14 @@ namespace vire
                 return array_type;
             }
 
-            case ast_call: return getFunction(((CallExprAST*)expr)->getIName().name)->getReturnType();
+            case ast_call:
+            {
+                auto* call=(CallExprAST*)expr;
+                if(call->getBuiltin()!=builtin_none)
+                    return call->getBuiltinType();
+
+                return getFunction(call->getIName().name)->getReturnType();
+            }
 
             case ast_array: return getType((ArrayExprAST*)expr);
 
@@ -272,13 +281,13 @@ namespace vire
     types::Base* VAnalyzer::getType(ArrayExprAST* const array)
     {
         const auto& vec=array->getElements();
-        auto type=types::copyType(getType(vec[0].get()));
+        auto* type=getType(vec[0].get());
 
         for(int i=0; i<vec.size(); ++i)
         {
             auto* new_type=getType(vec[i].get());
 
-            if(!types::isSame(type.get(), new_type))
+            if(!types::isSame(type, new_type))
             {
                 std::cout << "Error: Array element types do not match: " << *type << " " << *new_type << std::endl;
                 return nullptr;
@@ -287,8 +296,7 @@ namespace vire
         
         unsigned int len=((types::Array*)array->getType())->getLength();
 
-        auto type_uptr=std::make_unique<types::Array>(std::move(type), len);
-        array->setType(std::move(type_uptr));
+        array->setType(types::getArray(type, len));
 
         return array->getType();
     }
@@ -310,11 +318,8 @@ namespace vire
         bool types_are_arrays=(target->getType()==types::EType::Array || base->getType()==types::EType::Array);
         if(!types_are_user_defined && !types_are_arrays)
         {
-            auto src_type=types::copyType(base);
-            auto dst_type=types::copyType(target);
-
-            auto new_cast_value=std::make_unique<CastExprAST>(std::move(expr), std::move(dst_type), true);
-            new_cast_value->setSourceType(std::move(src_type));
+            auto new_cast_value=std::make_unique<CastExprAST>(std::move(expr), target, true);
+            new_cast_value->setSourceType(base);
 
             base=new_cast_value->getSourceType();
             target=new_cast_value->getDestType();
@@ -454,9 +459,7 @@ namespace vire
             }
             else
             {
-                auto value_type_uptr=types::copyType(value_type);
-
-                var->getValue()->setType(std::move(value_type_uptr));
+                var->getValue()->setType(value_type);
                 var->setUseValueType(true);
             }
             
@@ -503,8 +506,8 @@ namespace vire
             }
         }
 
-        assign->getLHS()->setType(types::copyType(lhs_type));
-        assign->getRHS()->setType(types::copyType(rhs_type));
+        assign->getLHS()->setType(lhs_type);
+        assign->getRHS()->setType(rhs_type);
         
         return is_valid;
     }
@@ -566,8 +569,8 @@ namespace vire
         }
         
         auto* array_ty=(types::Array*)type;
-        access->setType(types::copyType(array_ty->getChild()));
-        access->getExpr()->setType(types::copyType(array_ty));
+        access->setType(array_ty->getChild());
+        access->getExpr()->setType(array_ty);
 
         return true;
     }
@@ -590,10 +593,6 @@ namespace vire
                 return false;
             }
         }
-        
-        std::size_t elem_size=array->getElements()[0]->getType()->getSize();
-        std::size_t size=elem_size*elems.size();
-        array->getType()->setSize(size);
 
         return true;
     }
@@ -602,13 +601,18 @@ namespace vire
         if(!verifyExpr(cast->getExpr()))
             return false;
         auto* ty=getType(cast->getExpr());
-        cast->setSourceType(types::copyType(ty));
+        cast->setSourceType(ty);
         
         return true;
     }
 
     bool VAnalyzer::verifyFor(ForExprAST* const for_)
     { 
+        if(for_->isParallel())
+        {
+            return verifyParallelFor(for_);
+        }
+
         bool is_valid=true;
         const auto& init=for_->getInit();
         const auto& cond=for_->getCond();
@@ -646,6 +650,11 @@ namespace vire
             is_valid=false;
         }
 
+        if(!verifyLoopHints(for_->getHints()))
+        {
+            is_valid=false;
+        }
+
         if(!verifyBlock(for_->getBody()))
         {
             // Block is not valid
@@ -655,10 +664,205 @@ namespace vire
         
         return is_valid;
     }
+    bool VAnalyzer::verifyParallelFor(ForExprAST* const for_)
+    {
+        auto* init=for_->getInit();
+        auto* cond=for_->getCond();
+        auto* incr=for_->getIncr();
+
+        // Only `for(let i=start; i<end; i++)` or `i+=step` can be split into independent ranges
+        bool is_canonical=(init->asttype==ast_vardef && ((VariableDefAST*)init)->getValue()!=nullptr);
+        std::string induction=is_canonical ? ((VariableDefAST*)init)->getIName().name : "";
+
+        auto is_induction=[&induction](ExprAST* expr)
+        {
+            return expr->asttype==ast_var && ((VariableExprAST*)expr)->getIName().name==induction;
+        };
+
+        if(is_canonical)
+        {
+            auto* binop=(BinaryExprAST*)cond;
+            is_canonical=(cond->asttype==ast_binop && is_induction(binop->getLHS())
+            && (binop->getOp()->type==tok_lessthan || binop->getOp()->type==tok_lesseq));
+        }
+        if(is_canonical)
+        {
+            if(incr->asttype==ast_incrdecr)
+            {
+                auto* incrdecr=(IncrementDecrementAST*)incr;
+                is_canonical=(incrdecr->isIncrement() && is_induction(incrdecr->getExpr()));
+            }
+            else if(incr->asttype==ast_varassign)
+            {
+                auto* assign=(VariableAssignAST*)incr;
+                is_canonical=(assign->is_shorthand && assign->getShorthandOperator()->type==tok_plus && is_induction(assign->getLHS()));
+            }
+            else
+            {
+                is_canonical=false;
+            }
+        }
+        if(!is_canonical)
+        {
+            std::cout << "Verification Error: `@parallel` loops must have the form `for(let i=start; i<end; i++)` or `i+=step`" << std::endl;
+            return false;
+        }
+
+        // The start, end and step are evaluated once before the loop
+        bool is_valid=true;
+        auto* start=((VariableDefAST*)init)->getValue();
+        if(!verifyExpr(start) || !verifyExpr(((BinaryExprAST*)cond)->getRHS()))
+        {
+            return false;
+        }
+        if(incr->asttype==ast_varassign && !verifyExpr(((VariableAssignAST*)incr)->getRHS()))
+        {
+            return false;
+        }
+
+        auto* induction_type=getType(start);
+        if(!types::isNumericType(induction_type) || types::isTypeFloatingPoint(induction_type))
+        {
+            std::cout << "Verification Error: The induction variable `" << induction << "` of a `@parallel` loop must be an integer" << std::endl;
+            return false;
+        }
+
+        // Returns the variable at the root of an access chain like `foo.x` or `foo[i]`
+        auto get_root=[](ExprAST* expr) -> ExprAST*
+        {
+            while(expr->asttype==ast_type_access || expr->asttype==ast_array_access)
+            {
+                if(expr->asttype==ast_type_access)
+                    expr=((TypeAccessAST*)expr)->getParent();
+                else
+                    expr=((VariableArrayAccessAST*)expr)->getExpr();
+            }
+            return expr;
+        };
+
+        // Collect the captured variables in order of use, iterations run concurrently 
+        // so they cannot leave the loop or write to a captured scalar
+        std::vector<VariableDefAST*> captured;
+        std::unordered_set<std::string> seen;
+        std::function<void(ExprAST*, unsigned int)> visit=[&](ExprAST* expr, unsigned int loop_depth)
+        {
+            switch(expr->asttype)
+            {
+                case ast_return:
+                {
+                    std::cout << "Verification Error: Cannot `return` from a `@parallel` loop" << std::endl;
+                    is_valid=false;
+                    break;
+                }
+                case ast_break:
+                case ast_continue:
+                {
+                    if(loop_depth==0)
+                    {
+                        std::cout << "Verification Error: Cannot `break` or `continue` a `@parallel` loop" << std::endl;
+                        is_valid=false;
+                    }
+                    break;
+                }
+                case ast_var:
+                {
+                    auto const& name=((VariableExprAST*)expr)->getIName();
+                    if(name.name!=induction && isVariableDefined(name) && seen.insert(name.name).second)
+                    {
+                        captured.push_back(getVariable(name));
+                    }
+                    break;
+                }
+                case ast_varassign:
+                case ast_incrdecr:
+                {
+                    auto* target=(expr->asttype==ast_varassign) ? ((VariableAssignAST*)expr)->getLHS() : ((IncrementDecrementAST*)expr)->getExpr();
+                    auto* root=get_root(target);
+                    if(root->asttype!=ast_var)
+                        break;
+
+                    auto const& name=((VariableExprAST*)root)->getIName();
+                    if(name.name==induction)
+                    {
+                        std::cout << "Verification Error: Cannot modify the induction variable `" << induction << "` of a `@parallel` loop" << std::endl;
+                        is_valid=false;
+                    }
+                    else if(isVariableDefined(name) && target==root && !types::isUserDefined(getVariable(name)->getType()))
+                    {
+                        std::cout << "Verification Error: Cannot assign to `" << name.name << "` in a `@parallel` loop, the iterations run concurrently" << std::endl;
+                        is_valid=false;
+                    }
+                    break;
+                }
+                default: break;
+            }
+
+            if(expr->asttype==ast_for || expr->asttype==ast_while)
+                ++loop_depth;
+            forEachChild(expr, [&visit, loop_depth](ExprAST* child) { visit(child, loop_depth); });
+        };
+        for(auto const& stm : for_->getBody())
+        {
+            visit(stm.get(), 0);
+        }
+        if(!is_valid)
+        {
+            return false;
+        }
+
+        // Outline the body into `parent.parallel.N(i, captures...)`, structs and arrays are passed by reference
+        std::string parent_name=current_func ? current_func->getIName().name : "main";
+        std::string outlined_name=parent_name+".parallel."+std::to_string(parallel_loop_count++);
+
+        std::vector<std::unique_ptr<VariableDefAST>> args;
+        args.push_back(std::make_unique<VariableDefAST>(VToken::construct(induction), induction_type, nullptr, true, false));
+        for(auto* var : captured)
+        {
+            auto* type=var->getType();
+            auto arg=std::make_unique<VariableDefAST>(VToken::construct(var->getIName().name), type, nullptr, true, false);
+            arg->isReference(types::isUserDefined(type) || type->getType()==types::EType::Array);
+            args.push_back(std::move(arg));
+
+            auto capture=std::make_unique<VariableExprAST>(VToken::construct(var->getIName().name));
+            if(!verifyExpr(capture.get()))
+            {
+                return false;
+            }
+            capture->setType(type);
+            for_->addCapture(std::move(capture));
+        }
+
+        auto proto=std::make_unique<PrototypeAST>(VToken::construct(outlined_name), std::move(args), types::construct("void"));
+        auto outlined=std::make_unique<FunctionAST>(std::move(proto), for_->moveBody());
+        for_->setOutlinedName(outlined_name);
+
+        // The outlined function only sees its own arguments
+        auto outer_scope=std::move(scope);
+        auto* outer_varref=scope_varref;
+        auto* outer_func=current_func;
+        scope.clear();
+        scope_varref=nullptr;
+        current_func=outlined.get();
+
+        is_valid=verifyFunction(outlined.get());
+
+        scope=std::move(outer_scope);
+        scope_varref=outer_varref;
+        current_func=outer_func;
+
+        addFunction(std::move(outlined));
+        return is_valid;
+    }
     bool VAnalyzer::verifyWhile(WhileExprAST* const while_)
     {
         const auto& cond=while_->getCond();
 
+        if(while_->getHints().parallel)
+        {
+            std::cout << "Verification Error: Only `for` loops can be `@parallel`" << std::endl;
+            return false;
+        }
+
         if(cond->asttype!=ast_var && cond->asttype!=ast_unop && cond->asttype!=ast_binop)
         {
             // Cond is not a boolean expression
@@ -670,6 +874,10 @@ namespace vire
             // Cond is not valid
             return false;
         }
+        if(!verifyLoopHints(while_->getHints()))
+        {
+            return false;
+        }
         if(!verifyBlock(while_->getBody()))
         {
             // Block is not valid
@@ -678,6 +886,28 @@ namespace vire
 
         return true;
     }
+    bool VAnalyzer::verifyLoopHints(LoopHints const& hints)
+    {
+        bool is_valid=true;
+
+        if(hints.unroll_disable && (hints.unroll_full || hints.unroll_count))
+        {
+            std::cout << "Verification Error: Loop cannot be both `@unroll` and `@nounroll`" << std::endl;
+            is_valid=false;
+        }
+        if(hints.vectorize_disable && hints.vectorize_width)
+        {
+            std::cout << "Verification Error: Loop cannot be both `@vectorize` and `@novectorize`" << std::endl;
+            is_valid=false;
+        }
+        if(hints.vectorize_width & (hints.vectorize_width-1))
+        {
+            std::cout << "Verification Error: `@vectorize` width must be a power of two, got " << hints.vectorize_width << std::endl;
+            is_valid=false;
+        }
+
+        return is_valid;
+    }
     bool VAnalyzer::verifyBreak(BreakExprAST* const break_) { return true; }
     bool VAnalyzer::verifyContinue(ContinueExprAST* const continue_) { return true; }    
 
@@ -697,6 +927,12 @@ namespace vire
 
         if(!isFunctionDefined(name) && !is_recursive_call)
         {
+            // A user defined function with the same name takes precedence over the builtin
+            if(auto builtin=getBuiltinFunction(name); builtin!=builtin_none)
+            {
+                return verifyBuiltinCall(call, builtin);
+            }
+
             std::cout << "Function `" << name << "` is not defined" << std::endl;
             // Function is not defined
             return false;
@@ -719,9 +955,23 @@ namespace vire
             is_valid=false;
         }
 
-        for(unsigned int i=func->doesRequireSelfRef(); i<args.size(); ++i)
+        // The `self` argument is not written in the call, the arguments of the call start after it
+        unsigned int self_offset=func->doesRequireSelfRef();
+        for(unsigned int i=0; i<args.size() && i+self_offset<func_args.size(); ++i)
         {
             auto arg=std::move(args[i]);
+            auto* func_arg=func_args[i+self_offset].get();
+
+            // `&var` explicitly borrows the variable, only valid for reference arguments
+            if(arg->asttype==ast_reference)
+            {
+                if(!func_arg->isReference())
+                {
+                    std::cout << "Verification Error: Argument `" << func_arg->getIName().name << "` of `" << name << "` is not passed by reference" << std::endl;
+                    is_valid=false;
+                }
+                arg=((ReferenceExprAST*)arg.get())->moveVariable();
+            }
 
             if(!verifyExpr(arg.get()))
             {
@@ -733,13 +983,13 @@ namespace vire
 
             // This is to be changed, implemented for arguments with default value
             auto* arg_type=getType(arg.get());
-            if(!types::isSame(func_args[i]->getType(), arg_type))
+            if(!types::isSame(func_arg->getType(), arg_type))
             {
-                auto cast=tryCreateImplicitCast(func_args[i]->getType(), arg_type, std::move(arg));
+                auto cast=tryCreateImplicitCast(func_arg->getType(), arg_type, std::move(arg));
 
                 if(!cast)
                 {
-                    std::cout << "Error: Function call type mismatch, " << *func_args[i]->getType() << " : " << *arg_type << std::endl;
+                    std::cout << "Error: Function call type mismatch, " << *func_arg->getType() << " : " << *arg_type << std::endl;
                     is_valid=false;
                 }
                 else
@@ -747,7 +997,7 @@ namespace vire
                     arg=std::move(cast);
                 }
             }
-            arg->setType(types::copyType(arg_type));
+            arg->setType(arg_type);
 
             args[i]=std::move(arg);
         }
@@ -757,10 +1007,201 @@ namespace vire
             call->setArgs(std::move(args));
         }
 
-        call->setType(types::copyType(func->getReturnType()));
+        call->setType(func->getReturnType());
+
+        return is_valid;
+    }
+    bool VAnalyzer::verifyBuiltinCall(CallExprAST* const call, BuiltinFunction builtin)
+    {
+        auto const& name=call->getIName().name;
+        auto args=call->moveArgs();
+
+        unsigned int arg_count=getBuiltinArgCount(builtin);
+        if(args.size()!=arg_count)
+        {
+            std::cout << "Verification Error: Builtin `" << name << "` expects " << arg_count << " arguments, got " << args.size() << std::endl;
+            call->setArgs(std::move(args));
+            return false;
+        }
+
+        bool is_valid=true;
+        for(auto& arg : args)
+        {
+            if(arg->asttype==ast_reference)
+            {
+                arg=((ReferenceExprAST*)arg.get())->moveVariable();
+            }
+
+            if(!verifyExpr(arg.get()))
+            {
+                std::cout << "Call argument is not valid" << std::endl;
+                is_valid=false;
+            }
+        }
+        if(!is_valid)
+        {
+            call->setArgs(std::move(args));
+            return false;
+        }
+
+        if(!isMemoryBuiltin(builtin))
+        {
+            call->setArgs(std::move(args));
+            return verifyMathBuiltinCall(call, builtin);
+        }
+
+        // The destination is written in place, so it has to name an array or a struct
+        auto* dst_type=getType(args[0].get());
+        bool dst_is_aggregate=(dst_type->getType()==types::EType::Array || types::isUserDefined(dst_type));
+        if(args[0]->asttype!=ast_var || !dst_is_aggregate)
+        {
+            std::cout << "Verification Error: The first argument of `" << name << "` must be an array or a struct variable" << std::endl;
+            call->setArgs(std::move(args));
+            return false;
+        }
+
+        auto* value_type=getType(args[1].get());
+        switch(builtin)
+        {
+            case builtin_memset:
+            {
+                if(!types::isIntegerType(value_type))
+                {
+                    std::cout << "Verification Error: The value of `memset` must be an integer, but is " << *value_type << std::endl;
+                    is_valid=false;
+                }
+                break;
+            }
+            case builtin_memcpy:
+            {
+                if(args[1]->asttype!=ast_var || !types::isSame(dst_type, value_type))
+                {
+                    std::cout << "Verification Error: `memcpy` expects two variables of the same type, got " 
+                    << *dst_type << " and " << *value_type << std::endl;
+                    is_valid=false;
+                }
+                break;
+            }
+            case builtin_fill:
+            {
+                if(dst_type->getType()!=types::EType::Array)
+                {
+                    std::cout << "Verification Error: `fill` expects an array, got " << *dst_type << std::endl;
+                    is_valid=false;
+                    break;
+                }
+
+                auto* root_type=types::getArrayRootType(dst_type);
+                if(types::isUserDefined(root_type))
+                {
+                    std::cout << "Verification Error: `fill` expects an array of a primitive type, got " << *dst_type << std::endl;
+                    is_valid=false;
+                    break;
+                }
+                if(!types::isSame(root_type, value_type))
+                {
+                    auto cast=tryCreateImplicitCast(root_type, value_type, std::move(args[1]));
+                    if(!cast)
+                    {
+                        std::cout << "Error: Function call type mismatch, " << *root_type << " : " << *value_type << std::endl;
+                        call->setArgs(std::move(args));
+                        return false;
+                    }
+                    args[1]=std::move(cast);
+                }
+                break;
+            }
+            default: break;
+        }
+
+        for(auto& arg : args)
+        {
+            arg->setType(getType(arg.get()));
+        }
+
+        call->setArgs(std::move(args));
+        call->setBuiltin(builtin, types::construct(types::EType::Void));
 
         return is_valid;
     }
+    bool VAnalyzer::verifyMathBuiltinCall(CallExprAST* const call, BuiltinFunction builtin)
+    {
+        auto const& name=call->getIName().name;
+        auto args=call->moveArgs();
+
+        // The arguments are converted to a common type, floating point wins over integers, then the larger size
+        types::Base* common_type=nullptr;
+        for(auto const& arg : args)
+        {
+            auto* arg_type=getType(arg.get());
+            if(!types::isIntegerType(arg_type) && !types::isTypeFloatingPoint(arg_type))
+            {
+                std::cout << "Verification Error: Builtin `" << name << "` expects numeric arguments, got " << *arg_type << std::endl;
+                call->setArgs(std::move(args));
+                return false;
+            }
+
+            if(!common_type)
+            {
+                common_type=arg_type;
+                continue;
+            }
+
+            bool arg_is_fp=types::isTypeFloatingPoint(arg_type);
+            bool common_is_fp=types::isTypeFloatingPoint(common_type);
+            if((arg_is_fp && !common_is_fp) || (arg_is_fp==common_is_fp && arg_type->getSize()>common_type->getSize()))
+            {
+                common_type=arg_type;
+            }
+        }
+
+        auto result_type=common_type;
+        switch(builtin)
+        {
+            case builtin_sqrt:
+            case builtin_fma:
+            case builtin_floor:
+            {
+                if(!types::isTypeFloatingPoint(result_type))
+                {
+                    result_type=types::construct(types::EType::Double);
+                }
+                break;
+            }
+            case builtin_popcount:
+            case builtin_clz:
+            {
+                if(!types::isIntegerType(result_type))
+                {
+                    std::cout << "Verification Error: Builtin `" << name << "` expects an integer, got " << *result_type << std::endl;
+                    call->setArgs(std::move(args));
+                    return false;
+                }
+                break;
+            }
+            default: break;
+        }
+
+        for(auto& arg : args)
+        {
+            // Taken first, the cast replaces the type of literals
+            auto arg_type=getType(arg.get());
+            if(types::isSame(result_type, arg_type))
+            {
+                arg->setType(arg_type);
+                continue;
+            }
+
+            // Only numeric arguments get here, so the cast always succeeds and keeps its destination type
+            arg=tryCreateImplicitCast(result_type, arg_type, std::move(arg));
+        }
+
+        call->setArgs(std::move(args));
+        call->setType(result_type);
+        call->setBuiltin(builtin, result_type);
+
+        return true;
+    }
 
     bool VAnalyzer::verifyReturn(ReturnExprAST* const ret)
     {
@@ -796,7 +1237,7 @@ namespace vire
             getVariable(var_name)->isReturned(true);
         }
 
-        ret->getValue()->setType(types::copyType(ret_expr_type));
+        ret->getValue()->setType(ret_expr_type);
 
         return true;
     }
@@ -824,8 +1265,8 @@ namespace vire
             auto* left_type=getType(left);
             auto* right_type=getType(right);
 
-            left->setType(types::copyType(left_type));
-            right->setType(types::copyType(right_type));
+            left->setType(left_type);
+            right->setType(right_type);
 
             left_type=left->getType();
             right_type=right->getType();
@@ -856,7 +1297,7 @@ namespace vire
                 }
             }
 
-            binop->setType(types::copyType(binop->getLHS()->getType()));
+            binop->setType(binop->getLHS()->getType());
         }
 
         return is_valid;
@@ -927,10 +1368,55 @@ namespace vire
                 // Argument is not valid
                 is_valid=false;
             }
+
+            if(arg->isReference() && !types::isUserDefined(arg->getType()) && arg->getType()->getType()!=types::EType::Array)
+            {
+                std::cout << "Verification Error: Only structs and arrays can be passed by reference, `" << arg->getIName().name << "` is `" << *arg->getType() << "`" << std::endl;
+                is_valid=false;
+            }
+
+            bool is_pointer=(types::isUserDefined(arg->getType()) || arg->getType()->getType()==types::EType::Array);
+            if(arg->isNoAlias() && !is_pointer)
+            {
+                std::cout << "Verification Error: `@noalias` can only be used on struct or array arguments, `" << arg->getIName().name << "` is `" << *arg->getType() << "`" << std::endl;
+                is_valid=false;
+            }
+            if(proto->hasAttribute(fattr_pure) && is_pointer)
+            {
+                std::cout << "Verification Error: `@pure` function `" << proto->getIName().name << "` cannot take struct or array arguments, use `@readonly`" << std::endl;
+                is_valid=false;
+            }
             
             arg->isArgument(true);
         }
 
+        auto const& name=proto->getIName().name;
+        if(proto->hasAttribute(fattr_inline) && proto->hasAttribute(fattr_noinline))
+        {
+            std::cout << "Verification Error: Function `" << name << "` cannot be both `@inline` and `@noinline`" << std::endl;
+            is_valid=false;
+        }
+        if(proto->hasAttribute(fattr_hot) && proto->hasAttribute(fattr_cold))
+        {
+            std::cout << "Verification Error: Function `" << name << "` cannot be both `@hot` and `@cold`" << std::endl;
+            is_valid=false;
+        }
+        if(proto->hasAttribute(fattr_pure) && proto->hasAttribute(fattr_readonly))
+        {
+            std::cout << "Verification Error: Function `" << name << "` cannot be both `@pure` and `@readonly`" << std::endl;
+            is_valid=false;
+        }
+        if(proto->hasAttribute(fattr_pure) || proto->hasAttribute(fattr_readonly))
+        {
+            // Structs and arrays are returned by writing to the caller's memory
+            auto ret_ty=proto->getReturnType()->getType();
+            if(proto->isConstructor() || ret_ty==types::EType::Custom || ret_ty==types::EType::Array)
+            {
+                std::cout << "Verification Error: `@pure` or `@readonly` function `" << name << "` cannot return a struct or an array" << std::endl;
+                is_valid=false;
+            }
+        }
+
         return is_valid;
     }
     bool VAnalyzer::verifyProto(PrototypeAST* const proto)
@@ -963,7 +1449,7 @@ namespace vire
             // Prototype is not valid
             is_valid=false;
         }
-        func->setReturnType(types::copyType(func->getProto()->getReturnType()));
+        func->setReturnType(func->getProto()->getReturnType());
 
         for(auto const& var: func->getArgs())
         {
@@ -982,6 +1468,103 @@ namespace vire
             undefineVariable(var.get());
         }
 
+        if(is_valid && !verifyFunctionAttributes(func))
+        {
+            is_valid=false;
+        }
+
+        return is_valid;
+    }
+    bool VAnalyzer::verifyFunctionAttributes(FunctionAST* const func)
+    {
+        bool is_pure=func->hasAttribute(fattr_pure);
+        bool is_readonly=func->hasAttribute(fattr_readonly);
+        if(!is_pure && !is_readonly)
+        {
+            return true;
+        }
+
+        // Returns the argument at the root of an access chain like `arg.x` or `arg[i]`
+        auto get_root_argument=[func](ExprAST* expr) -> VariableDefAST*
+        {
+            while(expr->asttype==ast_type_access || expr->asttype==ast_array_access)
+            {
+                if(expr->asttype==ast_type_access)
+                    expr=((TypeAccessAST*)expr)->getParent();
+                else
+                    expr=((VariableArrayAccessAST*)expr)->getExpr();
+            }
+
+            if(expr->asttype!=ast_var || !func->isVariableDefined(((VariableExprAST*)expr)->getName()))
+                return nullptr;
+            
+            auto* var=func->getVariable(((VariableExprAST*)expr)->getName());
+            return var->isArgument() ? var : nullptr;
+        };
+
+        bool is_valid=true;
+        auto const& name=func->getIName().name;
+        for(auto const& stm : func->getBody())
+        {
+            forEachExpr(stm.get(), [&](ExprAST* expr)
+            {
+                if(expr->asttype==ast_call)
+                {
+                    auto const& callee_name=((CallExprAST*)expr)->getIName().name;
+                    if(callee_name==name)
+                        return;
+
+                    // Builtins only write to their first argument
+                    auto* call=(CallExprAST*)expr;
+                    if(call->getBuiltin()!=builtin_none)
+                    {
+                        if(!isMemoryBuiltin(call->getBuiltin()))
+                            return;
+
+                        if(auto* arg=get_root_argument(call->getArgs()[0].get()))
+                        {
+                            std::cout << "Verification Error: `" << (is_pure ? "@pure" : "@readonly") << "` function `" << name 
+                            << "` cannot modify the argument `" << arg->getIName().name << "` with `" << callee_name << "`" << std::endl;
+                            is_valid=false;
+                        }
+                        return;
+                    }
+
+                    auto* callee=getFunction(callee_name);
+                    if(!callee)
+                        return;
+                    
+                    // Constructors only write to the local they construct
+                    bool callee_ok=callee->isConstructor() || callee->hasAttribute(fattr_pure) || (is_readonly && callee->hasAttribute(fattr_readonly));
+                    if(!callee_ok)
+                    {
+                        std::cout << "Verification Error: `" << (is_pure ? "@pure" : "@readonly") << "` function `" << name 
+                        << "` cannot call `" << callee_name << "`, which is not marked `@pure`" << (is_readonly ? " or `@readonly`" : "") << std::endl;
+                        is_valid=false;
+                    }
+                }
+                else if(expr->asttype==ast_varassign || expr->asttype==ast_incrdecr)
+                {
+                    auto* target=(expr->asttype==ast_varassign) ? ((VariableAssignAST*)expr)->getLHS() : ((IncrementDecrementAST*)expr)->getExpr();
+                    if(target->asttype==ast_var)
+                        return;
+
+                    if(auto* arg=get_root_argument(target))
+                    {
+                        std::cout << "Verification Error: `@readonly` function `" << name << "` cannot modify the argument `" << arg->getIName().name << "`" << std::endl;
+                        is_valid=false;
+                    }
+                }
+                else if(expr->asttype==ast_for && ((ForExprAST*)expr)->isParallel())
+                {
+                    // The body was already moved into its own function and runs on the workers of the runtime, it is not checked here
+                    std::cout << "Verification Error: `" << (is_pure ? "@pure" : "@readonly") << "` function `" << name 
+                    << "` cannot contain a `@parallel` loop" << std::endl;
+                    is_valid=false;
+                }
+            });
+        }
+
         return is_valid;
     }
 
@@ -1022,13 +1605,15 @@ namespace vire
                     is_valid=false;
                 }
 
-                unsigned int size=0;
+                std::uint64_t size=0;
                 for(auto const& member : struct_->getMembersValues())
                 {
                     size+=member->getType()->getSize();
                 }
 
-                struct_->getType()->setSize(size);
+                auto* struct_type=types::getCustom(struct_->getName());
+                struct_type->setSize(size);
+                struct_->setType(struct_type);
             }
             else if(expr->asttype==ast_union)
             {
@@ -1073,7 +1658,7 @@ namespace vire
             return is_valid=false;
         }
 
-        unsigned int size=0;
+        std::uint64_t size=0;
         for(auto const& member : members)
         {
             size+=member->getType()->getSize();
@@ -1100,10 +1685,10 @@ namespace vire
         {
             constructor->isConstructor(true);
             constructor->doesRequireSelfRef(true);
-            constructor->setReturnType(types::copyType(struct_ty.get()));
+            constructor->setReturnType(struct_ty);
             constructor->setName(proto::IName(struct_->getIName().name, "struct_construct_"));
             
-            auto self_ref=std::make_unique<VariableDefAST>(VToken::construct("self", tok_id), types::copyType(struct_ty.get()), nullptr);
+            auto self_ref=std::make_unique<VariableDefAST>(VToken::construct("self", tok_id), struct_ty, nullptr);
             self_ref->isArgument(true);
             defineVariable(self_ref.get(), true);
             constructor->getModifyableArgs().insert(constructor->getArgs().begin(), std::move(self_ref));
@@ -1131,7 +1716,7 @@ namespace vire
 
             // Create the args
             std::unique_ptr<ExprAST> empty_val;
-            auto vardef=std::make_unique<VariableDefAST>(VToken::construct("", tok_id), types::copyType(struct_ty.get()), std::move(empty_val), false, true);
+            auto vardef=std::make_unique<VariableDefAST>(VToken::construct("", tok_id), struct_ty, std::move(empty_val), false, true);
             vardef->setName(proto::IName(self_ref_name, ""));
             vardef->isArgument(true);
             vars.push_back(vardef.get());
@@ -1148,7 +1733,7 @@ namespace vire
                 else if(member->asttype==ast_vardef)
                 {
                     auto* var=(VariableDefAST*)member;
-                    arg=std::make_unique<VariableDefAST>(VToken::construct(var->getIName().name, tok_id), types::copyType(var->getType()), std::move(empty_val));
+                    arg=std::make_unique<VariableDefAST>(VToken::construct(var->getIName().name, tok_id), var->getType(), std::move(empty_val));
                 }
 
                 arg->isArgument(true);
@@ -1168,21 +1753,21 @@ namespace vire
 
                 auto self_ref=std::make_unique<VariableExprAST>(VToken::construct("", tok_id));
                 self_ref->setName(proto::IName(self_ref_name, ""));
-                self_ref->setType(types::copyType(struct_ty.get()));
+                self_ref->setType(struct_ty);
                 auto mem=std::make_unique<VariableExprAST>(VToken::construct(member_name, tok_id));
-                mem->setType(types::copyType(member->getType()));
+                mem->setType(member->getType());
 
                 auto lhs=std::make_unique<TypeAccessAST>(std::move(self_ref), std::move(mem));
-                lhs->setType(types::copyType(member->getType()));
+                lhs->setType(member->getType());
                 
                 auto rhs=std::make_unique<VariableExprAST>(VToken::construct(member_name, tok_id));
-                rhs->setType(types::copyType(member->getType()));
+                rhs->setType(member->getType());
 
                 new_constructor_body.push_back(std::make_unique<VariableAssignAST>(std::move(lhs), std::move(rhs)));
             }
 
             // Set the constructor
-            auto new_constructor_proto=std::make_unique<PrototypeAST>(VToken::construct(st_iname.name), std::move(args), types::copyType(struct_ty.get()));
+            auto new_constructor_proto=std::make_unique<PrototypeAST>(VToken::construct(st_iname.name), std::move(args), struct_ty);
             auto new_constructor=std::make_unique<FunctionAST>(std::move(new_constructor_proto), std::move(new_constructor_body));
 
             new_constructor->setName(func_name);
@@ -1219,7 +1804,7 @@ namespace vire
             return false;
         }
 
-        access->getParent()->setType(types::copyType(ptype_custom));
+        access->getParent()->setType(ptype_custom);
         st=getStruct(ptype_custom->getName());
 
         IdentifierExprAST* possible_access=access;
@@ -1247,20 +1832,20 @@ namespace vire
             }
             else
             {
-                possible_struct_child->setType(std::make_unique<types::Custom>(casted_pos_stchild->getName(), 1));
-                casted_pos_access->getParent()->setType(std::make_unique<types::Custom>(casted_pos_stchild->getName(), 1));
+                possible_struct_child->setType(types::getCustom(casted_pos_stchild->getName()));
+                casted_pos_access->getParent()->setType(types::getCustom(casted_pos_stchild->getName()));
                 possible_access=child->getChild();
                 possible_struct_child=casted_pos_stchild->getMember(child->getIName());
             }
         }
 
         // Set the type for the tail of the access
-        possible_access->setType(types::copyType(possible_struct_child->getType()));
+        possible_access->setType(possible_struct_child->getType());
 
         if(is_valid)
         {
             auto* type=getType(access);
-            access->setType(types::copyType(type));
+            access->setType(type);
         }
 
         return is_valid;
@@ -1277,7 +1862,7 @@ namespace vire
         if(cond_type->getType()!=types::EType::Bool)
         {
             auto bool_type=types::construct(types::EType::Bool);
-            auto cast=tryCreateImplicitCast(bool_type.get(), cond_type, if_then->moveCondition());
+            auto cast=tryCreateImplicitCast(bool_type, cond_type, if_then->moveCondition());
 
             if(!cast)
             {
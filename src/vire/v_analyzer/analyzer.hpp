@@ -5,6 +5,8 @@
 #include "vire/errors/include.hpp"
 #include "vire/proto/iname.hpp"
 
+#include <string_view>
+
 namespace vire
 {
 
@@ -19,13 +21,16 @@ class VAnalyzer
     // Error Builder
     errors::ErrorBuilder* const builder;
 
-    // Source Code
-    std::string code;
+    // Source Code, viewed in the buffer of the caller which outlives the analyzer
+    std::string_view code;
 
     // Scope Stack
     std::map<std::string, VariableDefAST*> scope;
     std::vector<VariableDefAST*>* scope_varref;
 
+    // Number of `@parallel` loops outlined so far, used to name the outlined functions
+    unsigned int parallel_loop_count;
+
     // Type Stack
     std::map<std::string, ExprAST*> types;
 
@@ -42,8 +47,8 @@ class VAnalyzer
     VariableDefAST* const getVariable(std::string const& name);
     VariableDefAST* const getVariable(proto::IName const& name);
 public:
-    VAnalyzer(errors::ErrorBuilder* const builder, std::string const& code="")
-    : builder(builder), code(code), scope_varref(nullptr), current_func(nullptr), current_struct(nullptr) {}
+    VAnalyzer(errors::ErrorBuilder* const builder, std::string_view code={})
+    : builder(builder), code(code), scope_varref(nullptr), current_func(nullptr), current_struct(nullptr), parallel_loop_count(0) {}
 
     errors::ErrorBuilder* const getErrorBuilder() const { return builder; }
 
@@ -55,7 +60,7 @@ public:
 
     types::Base* getType(ExprAST* const expr);
     types::Base* getType(ArrayExprAST* const arr);
-    std::unique_ptr<types::Base> moveFuncReturnType(const std::string& name="");
+    types::Base* moveFuncReturnType(const std::string& name="");
 
     FunctionBaseAST* const getFunction(const std::string& name);
     StructExprAST* const getStruct(const std::string& name);
@@ -86,16 +91,21 @@ public:
     
     // Loop verifications
     bool verifyFor(ForExprAST* const for_);
+    bool verifyParallelFor(ForExprAST* const for_);
     bool verifyWhile(WhileExprAST* const while_);
+    bool verifyLoopHints(LoopHints const& hints);
     bool verifyBreak(BreakExprAST* const break_); // verification needed for break execution statement
     bool verifyContinue(ContinueExprAST* const continue_); // verification needed for continue execution statements
     
     // Function verifications
     bool verifyCall(CallExprAST* const call);
+    bool verifyBuiltinCall(CallExprAST* const call, BuiltinFunction builtin);
+    bool verifyMathBuiltinCall(CallExprAST* const call, BuiltinFunction builtin);
     bool verifyPrototype(PrototypeAST* const proto);
     bool verifyProto(PrototypeAST* const proto);
     bool verifyExtern(ExternAST* const extern_);
     bool verifyFunction(FunctionAST* const func);
+    bool verifyFunctionAttributes(FunctionAST* const func);
     bool verifyReturn(ReturnExprAST* const return_);
 
     // Operator and Cast verifications
@@ -3,6 +3,26 @@ add_library(
 
     ${SRC_DIR}/src/vire/v_compiler/codegen.hpp
     ${SRC_DIR}/src/vire/v_compiler/codegen.cpp
+    ${SRC_DIR}/src/vire/v_compiler/escape.hpp
+    ${SRC_DIR}/src/vire/v_compiler/escape.cpp
+    ${SRC_DIR}/src/vire/v_compiler/reachability.hpp
+    ${SRC_DIR}/src/vire/v_compiler/reachability.cpp
+    ${SRC_DIR}/src/vire/v_compiler/optimizer.hpp
+    ${SRC_DIR}/src/vire/v_compiler/optimizer.cpp
+    ${SRC_DIR}/src/vire/v_compiler/debuginfo.hpp
+    ${SRC_DIR}/src/vire/v_compiler/debuginfo.cpp
+    ${SRC_DIR}/src/vire/v_compiler/profile.hpp
+    ${SRC_DIR}/src/vire/v_compiler/profile.cpp
 )
 
+# The JIT runs on ORC, which the WebAssembly build does not link
+if(NOT VIRE_USE_EMCC)
+    target_sources(
+        vire-compiler PRIVATE
+
+        ${SRC_DIR}/src/vire/v_compiler/jit.hpp
+        ${SRC_DIR}/src/vire/v_compiler/jit.cpp
+    )
+endif()
+
 target_link_libraries(VIRELANG PRIVATE vire-compiler)
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "codegen.hpp"
+#include "optimizer.hpp"
 
 // LLVM
 #include "llvm/ADT/APFloat.h"
@@ -17,6 +18,12 @@
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
 
 #ifndef VIRE_NO_PASSES
 #include "llvm/Transforms/InstCombine/InstCombine.h"
@@ -32,6 +39,8 @@
 #include "llvm/Support/JSON.h"
 #endif
 
+#include <optional>
+
 //-- CHANGES REQUIRED: STRUCT PACKING --//
 
 namespace vire
@@ -71,6 +80,22 @@ namespace vire
                 return llvm::Type::getVoidTy(CTX);
         }
     }
+    TypeLayout const& VCompiler::getTypeLayout(types::Base* type)
+    {
+        auto* ty=getLLVMType(type, false);
+
+        auto it=typeLayouts.find(ty);
+        if(it!=typeLayouts.end())
+            return it->second;
+
+        TypeLayout layout{0, 1};
+        if(ty->isSized())
+        {
+            layout.size=data_layout->getTypeAllocSize(ty).getFixedValue();
+            layout.align=data_layout->getABITypeAlign(ty).value();
+        }
+        return typeLayouts[ty]=layout;
+    }
 
     void VCompiler::createSRetMemCpyForArg(ReturnExprAST* ret)
     {
@@ -80,7 +105,7 @@ namespace vire
         auto* dest=currentFunction->getArg(0);
         auto align=data_layout->getStructLayout((llvm::StructType*)ty)->getAlignment();
 
-        long nsize=ret->getValue()->getType()->getSize();
+        std::uint64_t nsize=getTypeLayout(ret->getValue()->getType()).size;
 
         Builder.CreateMemCpy(dest, align, src, align, nsize);
     }
@@ -96,17 +121,92 @@ namespace vire
         // Replace the old call with the new call
         auto* ncall=Builder.CreateCall(call->getCalledFunction(), new_args);
 
+        // Shift the existing parameter attributes (byval, align...) by one
+        auto attrs=call->getAttributes();
+        std::vector<llvm::AttributeSet> param_attrs;
+        param_attrs.push_back(llvm::AttributeSet());
+        for(unsigned i=0; i<call->arg_size(); ++i)
+        {
+            param_attrs.push_back(attrs.getParamAttrs(i));
+        }
+        ncall->setAttributes(llvm::AttributeList::get(CTX, attrs.getFnAttrs(), attrs.getRetAttrs(), param_attrs));
+
         call->eraseFromParent();
 
         return ncall;
     }
+    llvm::CallInst* VCompiler::compileCallIntoSRet(CallExprAST* const call, llvm::Value* dest)
+    {
+        // Constructs the returned struct/array directly into `dest`, no temporary or memcpy is required
+        auto* func=analyzer->getFunction(call->getIName().name);
+        llvm::CallInst* inst;
+
+        if(func->doesRequireSelfRef())
+            inst=(llvm::CallInst*)compileCallExpr(call, dest);
+        else
+            inst=(llvm::CallInst*)compileExpr(call);
+
+        if(!func->isConstructor())
+        {
+            inst=pushFrontToCallInst(dest, inst);
+            auto* ty=getLLVMType(func->getReturnType(), false);
+            uint64_t align=data_layout->getABITypeAlign(ty).value();
+            inst->addParamAttr(0, llvm::Attribute::get(CTX, llvm::Attribute::StructRet, ty));
+            inst->addParamAttr(0, llvm::Attribute::get(CTX, llvm::Attribute::Alignment, align));
+        }
+
+        return inst;
+    }
     llvm::Value* VCompiler::createAllocaForVar(VariableDefAST* const& var)
     {
         auto* ty=getLLVMType(var->getType(), false);
+
+        if(escape.canSplit(var))
+        {
+            // The struct never escapes, every field gets its own alloca so that it can be promoted
+            auto* st_ty=(llvm::StructType*)ty;
+            auto& fields=scalarizedStructs[var->getName()];
+            fields.clear();
+
+            for(unsigned i=0; i<st_ty->getNumElements(); ++i)
+            {
+                auto* field=Builder.CreateAlloca(st_ty->getElementType(i), nullptr, var->getName()+"."+std::to_string(i));
+                namedValues[field->getName()]=field;
+                fields.push_back(field);
+            }
+
+            return nullptr;
+        }
+
         auto* alloca=Builder.CreateAlloca(ty, nullptr, var->getName());
         namedValues[var->getName()]=alloca;
+        if(debug_info)
+            debug_info->declareVariable(var, alloca, Builder.GetInsertBlock());
         return alloca;
     }
+    void VCompiler::promoteLocals(llvm::Function* func)
+    {
+        // Turn every local whose address is never taken into SSA values, runs even without any passes
+        std::vector<llvm::AllocaInst*> allocas;
+        for(auto& inst : func->getEntryBlock())
+        {
+            if(auto* alloca=llvm::dyn_cast<llvm::AllocaInst>(&inst))
+            {
+                if(llvm::isAllocaPromotable(alloca))
+                    allocas.push_back(alloca);
+            }
+        }
+
+        if(!allocas.empty())
+        {
+            llvm::DominatorTree dt(*func);
+            llvm::PromoteMemToReg(allocas, dt);
+        }
+
+        // The promoted allocas are gone
+        namedValues.clear();
+        scalarizedStructs.clear();
+    }
     llvm::BranchInst* VCompiler::createBrIfNoTerminator(llvm::BasicBlock* block)
     {
         if (Builder.GetInsertBlock()->getTerminator() == nullptr)
@@ -118,6 +218,52 @@ namespace vire
             return nullptr;
         }
     }
+    void VCompiler::attachLoopHints(llvm::BasicBlock* header, llvm::BasicBlock* preheader, LoopHints const& hints)
+    {
+        if(hints.empty())
+            return;
+
+        // Operand 0 is the self reference that makes every loop id distinct
+        llvm::SmallVector<llvm::Metadata*, 4> ops;
+        ops.push_back(nullptr);
+
+        auto addHint=[&](const char* name, llvm::Constant* value=nullptr)
+        {
+            llvm::SmallVector<llvm::Metadata*, 2> hint={llvm::MDString::get(CTX, name)};
+            if(value)
+                hint.push_back(llvm::ConstantAsMetadata::get(value));
+            ops.push_back(llvm::MDNode::get(CTX, hint));
+        };
+
+        if(hints.unroll_disable)
+            addHint("llvm.loop.unroll.disable");
+        else if(hints.unroll_count)
+            addHint("llvm.loop.unroll.count", Builder.getInt32(hints.unroll_count));
+        else if(hints.unroll_full)
+            addHint("llvm.loop.unroll.full");
+
+        if(hints.vectorize_disable)
+            addHint("llvm.loop.vectorize.width", Builder.getInt32(1));
+        else if(hints.vectorize_width)
+        {
+            addHint("llvm.loop.vectorize.enable", Builder.getTrue());
+            addHint("llvm.loop.vectorize.width", Builder.getInt32(hints.vectorize_width));
+        }
+
+        if(hints.interleave_count)
+            addHint("llvm.loop.interleave.count", Builder.getInt32(hints.interleave_count));
+
+        auto* loop_id=llvm::MDNode::getDistinct(CTX, ops);
+        loop_id->replaceOperandWith(0, loop_id);
+
+        // Every back-edge into the header has to carry the same loop id
+        for(auto* pred : llvm::predecessors(header))
+        {
+            if(pred==preheader)
+                continue;
+            pred->getTerminator()->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+        }
+    }
     llvm::Value* VCompiler::getValueAsAlloca(llvm::Value* expr)
     {
         // Checks
@@ -255,6 +401,14 @@ namespace vire
     llvm::Value* VCompiler::compileExpr(ExprAST* const expr)
     {
         if(!expr)   { std::cout << "Invalid Expression" << std::endl;return nullptr; }
+
+        std::optional<DebugLocationScope> location;
+        if(debug_info)
+        {
+            if(auto* token=debug_info->getLineToken(expr))
+                location.emplace(Builder, debug_info->getLocation(token->line));
+        }
+
         switch(expr->asttype)
         {
             case ast_int:
@@ -477,6 +631,46 @@ namespace vire
         llvm::MaybeAlign lhs_align;
         auto const& value=def->getValue();
 
+        auto split=scalarizedStructs.find(def->getName());
+        if(split!=scalarizedStructs.end())
+        {
+            if(!value)
+            {
+                return nullptr;
+            }
+
+            // Inline the trivial constructor as a store to each field
+            auto* call=(CallExprAST*)value;
+            auto* ctor=(FunctionAST*)analyzer->getFunction(call->getIName().name);
+            auto* st=analyzer->getStruct(((types::Custom*)def->getType())->getName());
+
+            std::vector<llvm::Value*> args;
+            for(auto const& arg : call->getArgs())
+            {
+                args.push_back(compileExpr(arg.get()));
+            }
+
+            auto const& ctor_args=ctor->getArgs();
+            for(auto const& stm : ctor->getBody())
+            {
+                auto* assign=(VariableAssignAST*)stm.get();
+                auto* member=(TypeAccessAST*)assign->getLHS();
+                auto const& arg_name=((VariableExprAST*)assign->getRHS())->getName();
+
+                // `self` is the first argument of the constructor
+                for(unsigned i=1; i<ctor_args.size(); ++i)
+                {
+                    if(ctor_args[i]->getName()==arg_name)
+                    {
+                        Builder.CreateStore(args[i-1], split->second[st->getMemberIndex(member->getIName())]);
+                        break;
+                    }
+                }
+            }
+
+            return nullptr;
+        }
+
         if(def->isReturned() && current_func_single_sret)
         {
             auto* arg=currentFunction->getArg(0);
@@ -499,23 +693,7 @@ namespace vire
         {
             if(value->asttype==ast_call)
             {
-                auto* func=analyzer->getFunction(((CallExprAST*)def->getValue())->getIName().name);
-                llvm::CallInst* call;
-
-                if(func->doesRequireSelfRef())
-                    call=(llvm::CallInst*)compileCallExpr((CallExprAST*)def->getValue(), lhs);
-                else
-                    call=(llvm::CallInst*)compileExpr(def->getValue());
-
-                if(!func->isConstructor())
-                {
-                    call=pushFrontToCallInst(lhs, call);
-                    auto* ty=getLLVMType(func->getReturnType(), false);
-                    uint64_t align=data_layout->getStructLayout((llvm::StructType*)ty)->getAlignment().value();
-                    call->addParamAttr(0, llvm::Attribute::get(CTX, llvm::Attribute::StructRet, ty));
-                    call->addParamAttr(0, llvm::Attribute::get(CTX, llvm::Attribute::Alignment, align));
-                }
-
+                compileCallIntoSRet((CallExprAST*)value, lhs);
                 return lhs;
             }
             else
@@ -523,7 +701,7 @@ namespace vire
                 auto* val=compileExpr(def->getValue());
                 auto* alloca_rhs=(llvm::AllocaInst*)getValueAsAlloca(val);
 
-                auto size=llvm::APInt(64, def->getType()->getSize(), false);
+                auto size=llvm::APInt(64, getTypeLayout(def->getType()).size, false);
                 auto* memcpy=Builder.CreateMemCpy(lhs, lhs_align, alloca_rhs, lhs_align, llvm::ConstantInt::get(CTX, size));
             }
         }
@@ -531,9 +709,7 @@ namespace vire
         {
             if(value->asttype==ast_call)
             {
-                auto* call=(llvm::CallInst*)compileExpr(value);
-                pushFrontToCallInst(lhs, call);
-
+                compileCallIntoSRet((CallExprAST*)value, lhs);
                 return lhs;
             }
             else
@@ -545,10 +721,10 @@ namespace vire
 
                 // Set the size of the array
                 auto* array_ast=(ArrayExprAST* const)value;
-                std::size_t size=array_ast->getType()->getSize();
+                std::uint64_t size=getTypeLayout(array_ast->getType()).size;
 
                 // Create the memcpy call
-                auto* call_inst=Builder.CreateMemCpy(lhs, lhs_align, val, lhs_align, llvm::ConstantInt::get(CTX, llvm::APInt(64, size, true)));
+                auto* call_inst=Builder.CreateMemCpy(lhs, lhs_align, val, lhs_align, llvm::ConstantInt::get(CTX, llvm::APInt(64, size, false)));
             }
         }
         else
@@ -582,7 +758,7 @@ namespace vire
             auto lhs_align=alloca_lhs->getAlign();
             auto rhs_align=alloca_rhs->getAlign();
 
-            auto size=llvm::APInt(64, assign->getLHS()->getType()->getSize(), false);
+            auto size=llvm::APInt(64, getTypeLayout(assign->getLHS()->getType()).size, false);
             auto* memcpy=Builder.CreateMemCpy(alloca_lhs, lhs_align, alloca_rhs, rhs_align, llvm::ConstantInt::get(CTX, size));
 
             return memcpy;
@@ -817,8 +993,32 @@ namespace vire
         return ifthen;
     }
 
+    VProfiler::Site VCompiler::createLoopProfileSite(ExprAST* const loop, std::string const& kind)
+    {
+        // Loops are named after their function and the line they start at, eg - `_main:for@12`
+        auto name=currentFunction->getName().str()+":"+kind;
+        if(auto* token=VDebugInfo::getLineToken(loop))
+            name+="@"+std::to_string(token->line+1);
+
+        return profiler->createSite(name);
+    }
     llvm::Value* VCompiler::compileForExpr(ForExprAST* const forexpr)
     {
+        std::optional<VProfiler::Site> profile_site;
+        if(profiler)
+        {
+            profile_site=createLoopProfileSite(forexpr, "for");
+            profiler->enter(Builder, *profile_site);
+        }
+
+        if(forexpr->isParallel())
+        {
+            auto* call=compileParallelForExpr(forexpr);
+            if(profile_site)
+                profiler->exit(Builder, *profile_site);
+            return call;
+        }
+
         auto* init=compileExpr(forexpr->getInit());
 
         auto* forbool=llvm::BasicBlock::Create(CTX, "forb", currentFunction);
@@ -827,6 +1027,7 @@ namespace vire
         currentLoopEndBB=forcont;
         currentLoopBodyBB=forloop;
 
+        auto* forpre=Builder.GetInsertBlock();
         Builder.CreateBr(forbool);
         Builder.SetInsertPoint(forbool);
         auto* cond=compileExpr(forexpr->getCond());
@@ -836,10 +1037,128 @@ namespace vire
         compileBlock(forexpr->getBody());
         auto* incr=compileExpr(forexpr->getIncr());
         createBrIfNoTerminator(forbool);
+        attachLoopHints(forbool, forpre, forexpr->getHints());
 
         Builder.SetInsertPoint(forcont);
+        if(profile_site)
+            profiler->exit(Builder, *profile_site);
         return br;
     }
+    llvm::Value* VCompiler::compileParallelForExpr(ForExprAST* const forexpr)
+    {
+        auto* i64=Builder.getInt64Ty();
+        auto* init=(VariableDefAST*)forexpr->getInit();
+        auto* cond=(BinaryExprAST*)forexpr->getCond();
+        auto* incr=forexpr->getIncr();
+
+        // Start, end and step are evaluated once
+        auto* start=Builder.CreateSExt(compileExpr(init->getValue()), i64, "pstart");
+        auto* end=Builder.CreateSExt(compileExpr(cond->getRHS()), i64, "pend");
+        if(cond->getOp()->type==tok_lesseq)
+        {
+            end=Builder.CreateAdd(end, Builder.getInt64(1), "pend", false, true);
+        }
+
+        llvm::Value* step=Builder.getInt64(1);
+        if(incr->asttype==ast_varassign)
+        {
+            step=Builder.CreateSExt(compileExpr(((VariableAssignAST*)incr)->getRHS()), i64, "pstep");
+        }
+
+        // count = ceil((end-start)/step), no iterations for an empty range or a non-positive step
+        auto* span=Builder.CreateSub(end, start, "pspan");
+        auto* count=Builder.CreateSDiv(Builder.CreateAdd(span, Builder.CreateSub(step, Builder.getInt64(1))), step, "pcount");
+        auto* is_empty=Builder.CreateOr(Builder.CreateICmpSLE(span, Builder.getInt64(0)), Builder.CreateICmpSLE(step, Builder.getInt64(0)));
+        count=Builder.CreateSelect(is_empty, Builder.getInt64(0), count, "pcount");
+
+        // The context holds the start, the step and then every captured value
+        std::vector<llvm::Value*> ctx_values={start, step};
+        for(auto const& capture : forexpr->getCaptures())
+        {
+            ctx_values.push_back(compileExpr(capture.get()));
+        }
+
+        std::vector<llvm::Type*> ctx_types;
+        for(auto* value : ctx_values)
+        {
+            ctx_types.push_back(value->getType());
+        }
+
+        // Allocated in the entry block so that a loop around this one does not grow the stack
+        auto* ctx_type=llvm::StructType::get(CTX, ctx_types);
+        auto& entry=currentFunction->getEntryBlock();
+        llvm::IRBuilder<> entry_builder(&entry, entry.begin());
+        auto* ctx=entry_builder.CreateAlloca(ctx_type, nullptr, "pctx");
+        for(unsigned i=0; i<ctx_values.size(); ++i)
+        {
+            Builder.CreateStore(ctx_values[i], Builder.CreateStructGEP(ctx_type, ctx, i));
+        }
+
+        // The outlined body is inlined into the range function
+        auto* outlined=Module->getFunction(analyzer->getFunction(forexpr->getOutlinedName())->getName());
+        outlined->addFnAttr(llvm::Attribute::AlwaysInline);
+        outlined->setLinkage(llvm::GlobalValue::InternalLinkage);
+
+        auto* range_func=createParallelRangeFunction(outlined, ctx_type, forexpr->getHints());
+
+        // void vire_parallel_for(i64 begin, i64 end, void(*)(i64, i64, ptr), ptr ctx) - defined in the runtime
+        auto* ptr_ty=llvm::PointerType::get(CTX, 0);
+        auto runtime_func=Module->getOrInsertFunction("vire_parallel_for", 
+        llvm::FunctionType::get(Builder.getVoidTy(), {i64, i64, ptr_ty, ptr_ty}, false));
+
+        return Builder.CreateCall(runtime_func, {Builder.getInt64(0), count, range_func, ctx});
+    }
+    llvm::Function* VCompiler::createParallelRangeFunction(llvm::Function* outlined, llvm::StructType* ctx_type, LoopHints const& hints)
+    {
+        // Runs the iterations [begin, end) of a `@parallel` loop, called by the runtime on each worker
+        auto* i64=Builder.getInt64Ty();
+        auto* ptr_ty=llvm::PointerType::get(CTX, 0);
+        auto* func_type=llvm::FunctionType::get(Builder.getVoidTy(), {i64, i64, ptr_ty}, false);
+        auto* func=llvm::Function::Create(func_type, llvm::Function::InternalLinkage, outlined->getName()+".range", Module.get());
+
+        auto* begin=func->getArg(0);
+        auto* end=func->getArg(1);
+        auto* ctx=func->getArg(2);
+        begin->setName("begin");
+        end->setName("end");
+        ctx->setName("ctx");
+
+        auto* entry=llvm::BasicBlock::Create(CTX, "entry", func);
+        auto* loop=llvm::BasicBlock::Create(CTX, "pforl", func);
+        auto* exit=llvm::BasicBlock::Create(CTX, "pforc", func);
+        llvm::IRBuilder<> builder(entry);
+        if(debug_info)
+            builder.SetCurrentDebugLocation(debug_info->describeArtificialFunction(func, Builder.getCurrentDebugLocation()));
+
+        auto* start=builder.CreateLoad(i64, builder.CreateStructGEP(ctx_type, ctx, 0), "start");
+        auto* step=builder.CreateLoad(i64, builder.CreateStructGEP(ctx_type, ctx, 1), "step");
+
+        std::vector<llvm::Value*> args={nullptr};
+        for(unsigned i=2; i<ctx_type->getNumElements(); ++i)
+        {
+            args.push_back(builder.CreateLoad(ctx_type->getElementType(i), builder.CreateStructGEP(ctx_type, ctx, i)));
+        }
+        builder.CreateCondBr(builder.CreateICmpSLT(begin, end), loop, exit);
+
+        // i = start + k*step for every k in [begin, end)
+        builder.SetInsertPoint(loop);
+        auto* k=builder.CreatePHI(i64, 2, "k");
+        k->addIncoming(begin, entry);
+
+        auto* induction=builder.CreateAdd(start, builder.CreateMul(k, step, "", false, true), "", false, true);
+        args[0]=builder.CreateTrunc(induction, outlined->getArg(0)->getType(), "i");
+        builder.CreateCall(outlined, args);
+
+        auto* next=builder.CreateAdd(k, builder.getInt64(1), "k.next", false, true);
+        k->addIncoming(next, loop);
+        builder.CreateCondBr(builder.CreateICmpSLT(next, end), loop, exit);
+
+        builder.SetInsertPoint(exit);
+        builder.CreateRetVoid();
+
+        attachLoopHints(loop, entry, hints);
+        return func;
+    }
     llvm::Value* VCompiler::compileWhileExpr(WhileExprAST* const whileexpr)
     {
         auto whilebool=llvm::BasicBlock::Create(CTX, "whileb", currentFunction);
@@ -848,6 +1167,14 @@ namespace vire
         currentLoopEndBB=whilecont;
         currentLoopBodyBB=whileloop;
 
+        std::optional<VProfiler::Site> profile_site;
+        if(profiler)
+        {
+            profile_site=createLoopProfileSite(whileexpr, "while");
+            profiler->enter(Builder, *profile_site);
+        }
+
+        auto* whilepre=Builder.GetInsertBlock();
         Builder.CreateBr(whilebool);
         Builder.SetInsertPoint(whilebool);
         auto* cond=compileExpr(whileexpr->getCond());
@@ -856,8 +1183,11 @@ namespace vire
         Builder.SetInsertPoint(whileloop);
         compileBlock(whileexpr->getBody());
         createBrIfNoTerminator(whilebool);
+        attachLoopHints(whilebool, whilepre, whileexpr->getHints());
 
         Builder.SetInsertPoint(whilecont);
+        if(profile_site)
+            profiler->exit(Builder, *profile_site);
 
         return br;
     }
@@ -876,6 +1206,11 @@ namespace vire
 
     llvm::Value* VCompiler::compileCallExpr(CallExprAST* const expr, llvm::Value* parent_struct)
     {
+        if(expr->getBuiltin()!=builtin_none)
+        {
+            return compileBuiltinCall(expr);
+        }
+
         std::string func_name;
         auto* afunc=analyzer->getFunction(expr->getIName().name);
 
@@ -919,12 +1254,20 @@ namespace vire
             auto* ty=(llvm::StructType*)getLLVMType(afunc->getReturnType(), false);
             uint64_t align=data_layout->getStructLayout(ty)->getAlignment().value();
             call->addParamAttr(0, llvm::Attribute::get(CTX, llvm::Attribute::Alignment, align));
-            call->addParamAttr(0, llvm::Attribute::get(CTX, llvm::Attribute::Dereferenceable, afunc->getReturnType()->getSize()));
+            call->addParamAttr(0, llvm::Attribute::get(CTX, llvm::Attribute::Dereferenceable, getTypeLayout(afunc->getReturnType()).size));
         }
         for(auto& arg : expr->getArgs())
         {
             call->addParamAttr(indx, llvm::Attribute::NoUndef);
-            if(types::isUserDefined(arg->getType()))
+            if(afunc->getArgs()[indx]->isReference())
+            {
+                // Passed by reference, the callee works on the caller's memory
+                auto* ty=getLLVMType(arg->getType(), false);
+                call->addParamAttr(indx, llvm::Attribute::NonNull);
+                call->addParamAttr(indx, llvm::Attribute::get(CTX, llvm::Attribute::Alignment, data_layout->getABITypeAlign(ty).value()));
+                call->addParamAttr(indx, llvm::Attribute::get(CTX, llvm::Attribute::Dereferenceable, data_layout->getTypeAllocSize(ty).getFixedValue()));
+            }
+            else if(types::isUserDefined(arg->getType()))
             {
                 auto* ty=getLLVMType(arg->getType());
                 uint64_t align=data_layout->getStructLayout((llvm::StructType*)ty)->getAlignment().value();
@@ -937,27 +1280,134 @@ namespace vire
 
         return call;
     }
+    llvm::Value* VCompiler::compileBuiltinCall(CallExprAST* const expr)
+    {
+        auto const& args=expr->getArgs();
+        if(!isMemoryBuiltin(expr->getBuiltin()))
+        {
+            // The analyzer casts the arguments to the result type, every builtin maps to a single intrinsic
+            std::vector<llvm::Value*> values;
+            for(auto const& arg : args)
+            {
+                values.push_back(compileExpr(arg.get()));
+            }
+
+            auto* ty=values[0]->getType();
+            bool is_fp=ty->isFloatingPointTy();
+            switch(expr->getBuiltin())
+            {
+                case builtin_sqrt: return Builder.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, values[0], nullptr, "sqrttmp");
+                case builtin_floor: return Builder.CreateUnaryIntrinsic(llvm::Intrinsic::floor, values[0], nullptr, "floortmp");
+                case builtin_fma: return Builder.CreateIntrinsic(llvm::Intrinsic::fma, {ty}, values, nullptr, "fmatmp");
+                case builtin_abs:
+                {
+                    if(is_fp)
+                        return Builder.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, values[0], nullptr, "abstmp");
+                    return Builder.CreateIntrinsic(llvm::Intrinsic::abs, {ty}, {values[0], Builder.getFalse()}, nullptr, "abstmp");
+                }
+                case builtin_min:
+                {
+                    if(is_fp)
+                        return Builder.CreateMinNum(values[0], values[1], "mintmp");
+                    return Builder.CreateBinaryIntrinsic(llvm::Intrinsic::smin, values[0], values[1], nullptr, "mintmp");
+                }
+                case builtin_max:
+                {
+                    if(is_fp)
+                        return Builder.CreateMaxNum(values[0], values[1], "maxtmp");
+                    return Builder.CreateBinaryIntrinsic(llvm::Intrinsic::smax, values[0], values[1], nullptr, "maxtmp");
+                }
+                case builtin_popcount: return Builder.CreateUnaryIntrinsic(llvm::Intrinsic::ctpop, values[0], nullptr, "popcnttmp");
+                case builtin_clz: return Builder.CreateIntrinsic(llvm::Intrinsic::ctlz, {ty}, {values[0], Builder.getFalse()}, nullptr, "clztmp");
+                default: break;
+            }
+
+            return nullptr;
+        }
+
+        auto* ty=getLLVMType(args[0]->getType(), false);
+        auto align=data_layout->getABITypeAlign(ty);
+        uint64_t size=data_layout->getTypeAllocSize(ty).getFixedValue();
+
+        auto* dst=compileExpr(args[0].get());
+        switch(expr->getBuiltin())
+        {
+            case builtin_memset:
+            {
+                auto* value=Builder.CreateIntCast(compileExpr(args[1].get()), Builder.getInt8Ty(), false);
+                return Builder.CreateMemSet(dst, value, size, align);
+            }
+            case builtin_memcpy:
+            {
+                auto* src=compileExpr(args[1].get());
+                return Builder.CreateMemCpy(dst, align, src, align, size);
+            }
+            case builtin_fill:
+            {
+                auto* value=compileExpr(args[1].get());
+
+                // A value with the same byte repeated, eg - `0` or `-1`, is a memset
+                auto* byte=llvm::isBytewiseValue(value, *data_layout);
+                if(byte && !llvm::isa<llvm::UndefValue>(byte))
+                {
+                    return Builder.CreateMemSet(dst, byte, size, align);
+                }
+
+                // Otherwise store to the flattened elements, the vectorizer turns this into wide stores
+                auto* elem_ty=getLLVMType(types::getArrayRootType(args[0]->getType()), false);
+                uint64_t count=size/data_layout->getTypeAllocSize(elem_ty).getFixedValue();
+                if(count==0)
+                {
+                    return nullptr;
+                }
+
+                auto* i64=Builder.getInt64Ty();
+                auto* fillpre=Builder.GetInsertBlock();
+                auto* fillloop=llvm::BasicBlock::Create(CTX, "filll", currentFunction);
+                auto* fillcont=llvm::BasicBlock::Create(CTX, "fillc", currentFunction);
+                Builder.CreateBr(fillloop);
+
+                Builder.SetInsertPoint(fillloop);
+                auto* idx=Builder.CreatePHI(i64, 2, "fillidx");
+                idx->addIncoming(llvm::ConstantInt::get(i64, 0), fillpre);
+                Builder.CreateStore(value, Builder.CreateInBoundsGEP(elem_ty, dst, idx, "fillgep"));
+                auto* next=Builder.CreateAdd(idx, llvm::ConstantInt::get(i64, 1), "fillnext", true, true);
+                idx->addIncoming(next, fillloop);
+                auto* br=Builder.CreateCondBr(Builder.CreateICmpULT(next, llvm::ConstantInt::get(i64, count)), fillloop, fillcont);
+
+                Builder.SetInsertPoint(fillcont);
+                return br;
+            }
+            default: break;
+        }
+
+        return nullptr;
+    }
     llvm::Value* VCompiler::compileReturnExpr(ReturnExprAST* const expr)
     {
+        bool returns_sret=(types::isUserDefined(currentFunctionAST->getReturnType()) 
+        || currentFunctionAST->getReturnType()->getType()==types::EType::Array);
+
+        // `return foo(...)` - let the callee write directly into our sret pointer
+        if(returns_sret && expr->getValue()->asttype==ast_call)
+        {
+            auto* call=compileCallIntoSRet((CallExprAST*)expr->getValue(), currentFunction->getArg(0));
+            Builder.CreateBr(currentFunctionEndBB);
+
+            return call;
+        }
+
         auto* expr_val=compileExpr(expr->getValue());
 
-        if(types::isUserDefined(currentFunctionAST->getReturnType()) 
-        || currentFunctionAST->getReturnType()->getType()==types::EType::Array)
+        if(returns_sret)
         {
             llvm::Value* arg0=currentFunction->getArg(0);
             
-            std::size_t nsize;
             auto align=((llvm::Argument*)arg0)->getParamAlign();
-            if(types::isUserDefined(currentFunctionAST->getReturnType()))
-            {
-                // If its a struct
-                nsize=types::custom_type_sizes[((types::Custom*)expr->getValue()->getType())->getName()];
-            }
-            else
+            std::uint64_t nsize=getTypeLayout(expr->getValue()->getType()).size;
+            if(!types::isUserDefined(currentFunctionAST->getReturnType()))
             {
                 // If its an array
-                nsize=((types::Array*)expr->getValue()->getType())->getSize();
-
                 if(auto* gep=llvm::dyn_cast<llvm::GetElementPtrInst>(expr_val))
                 {
                     expr_val=gep->getPointerOperand();
@@ -1024,7 +1474,7 @@ namespace vire
             attrs.addAttribute(llvm::Attribute::NoUndef);
             attrs.addAttribute(llvm::Attribute::NonNull);
             attrs.addAlignmentAttr(data_layout->getStructLayout(ty)->getAlignment());
-            attrs.addDereferenceableAttr(proto->getReturnType()->getSize());
+            attrs.addDereferenceableAttr(getTypeLayout(proto->getReturnType()).size);
             arg->addAttrs(attrs);
             arg->setName("self");
         }
@@ -1033,7 +1483,23 @@ namespace vire
             auto* arg=func->getArg(idx+func_rets_ty);
             arg->setName("a"+proto_args[idx]->getName());
 
-            if(types::isUserDefined(proto_args[idx]->getType()))
+            if(proto_args[idx]->isNoAlias())
+            {
+                arg->addAttr(llvm::Attribute::NoAlias);
+            }
+
+            if(proto_args[idx]->isReference())
+            {
+                auto* ty=getLLVMType(proto_args[idx]->getType(), false);
+
+                llvm::AttrBuilder attrs(CTX);
+                attrs.addAttribute(llvm::Attribute::NoUndef);
+                attrs.addAttribute(llvm::Attribute::NonNull);
+                attrs.addAlignmentAttr(data_layout->getABITypeAlign(ty));
+                attrs.addDereferenceableAttr(data_layout->getTypeAllocSize(ty).getFixedValue());
+                arg->addAttrs(attrs);
+            }
+            else if(types::isUserDefined(proto_args[idx]->getType()))
             {
                 auto* ty=getLLVMType(proto_args[idx]->getType(), false);
 
@@ -1051,11 +1517,23 @@ namespace vire
             llvm::AttrBuilder attrs(CTX);
             attrs.addStructRetAttr(ty);
             attrs.addAttribute(llvm::Attribute::NoAlias);
-            attrs.addAlignmentAttr(data_layout->getStructLayout((llvm::StructType*)ty)->getAlignment());
+            attrs.addAlignmentAttr(data_layout->getABITypeAlign(ty));
 
             func->addParamAttrs(0, attrs);
         }
 
+        // User given `@attr` attributes
+        if(proto->hasAttribute(fattr_inline))   func->addFnAttr(llvm::Attribute::InlineHint);
+        if(proto->hasAttribute(fattr_noinline)) func->addFnAttr(llvm::Attribute::NoInline);
+        if(proto->hasAttribute(fattr_hot))      func->addFnAttr(llvm::Attribute::Hot);
+        if(proto->hasAttribute(fattr_cold))     func->addFnAttr(llvm::Attribute::Cold);
+        // Instrumented functions call the profiler, which writes to its sites, so they keep no memory attributes
+        if(!instrument)
+        {
+            if(proto->hasAttribute(fattr_pure))     func->setDoesNotAccessMemory();
+            if(proto->hasAttribute(fattr_readonly)) func->setOnlyReadsMemory();
+        }
+
         func->addFnAttr(llvm::Attribute::get(CTX, "wasm-export-name", func->getName()));
         func->setVisibility(llvm::GlobalValue::DefaultVisibility);
 
@@ -1067,6 +1545,29 @@ namespace vire
         llvm::Function* func=compilePrototype(ext->getProto());
         func->setName(ext->getIName().name);
 
+        // The math functions of libvirert and libm do not touch memory, calls to them can be moved and merged
+        static const std::unordered_set<std::string> math_functions=
+        {
+            "ipow", "lpow", "isqrt", "rsqrt", "rsqrtf", "lerp", "clampd",
+            "sqrt", "sqrtf", "sin", "sinf", "cos", "cosf", "tan", "tanf", 
+            "exp", "expf", "log", "logf", "pow", "powf", "fabs", "fabsf", "floor", "floorf", "ceil", "ceilf",
+        };
+        static const std::unordered_set<std::string> io_functions=
+        {
+            "puti", "putl", "putf", "putd", "putch", "putb", "vire_flush",
+        };
+
+        if(math_functions.count(ext->getIName().name))
+        {
+            func->setDoesNotAccessMemory();
+            func->setDoesNotThrow();
+            func->setWillReturn();
+        }
+        else if(io_functions.count(ext->getIName().name))
+        {
+            func->setDoesNotThrow();
+        }
+
         // Remove in release
         // func->print(error_os);
         return func;
@@ -1088,6 +1589,25 @@ namespace vire
         namedValues.clear();
         bool func_ret_ty=((func_ty==types::EType::Custom || func_ty==types::EType::Array) && !func->isConstructor());
 
+        if(debug_info)
+        {
+            auto line=func->getNameToken() ? func->getNameToken()->line : 0;
+            debug_info->beginFunction(function, func, line);
+            Builder.SetCurrentDebugLocation(debug_info->getLocation(line));
+
+            for(unsigned idx=0; debug_info->isFull() && idx<func_args.size(); ++idx)
+            {
+                debug_info->declareArgument(func_args[idx].get(), idx+1, function->getArg(idx+func_ret_ty), bb);
+            }
+        }
+
+        std::optional<VProfiler::Site> profile_site;
+        if(profiler)
+        {
+            profile_site=profiler->createSite(function->getName().str());
+            profiler->enter(Builder, *profile_site);
+        }
+
         // Create return value
         llvm::Type* ret_type=getLLVMType(func->getReturnType());
         bool func_returns=(func_ty!=types::EType::Void && !func_ret_ty && !func->isConstructor());
@@ -1122,6 +1642,7 @@ namespace vire
         current_func_single_sret=((single_var_ret && func_ret_ty) || func->isConstructor());
         current_func_ret_ty=func_ret_ty;
 
+        escape.analyze(func->getBody());
         for(auto& [vname, var]: func->getLocals())
         {
             if(var->isArgument())
@@ -1137,6 +1658,8 @@ namespace vire
 
         // Create the return instruction
         Builder.SetInsertPoint(currentFunctionEndBB);
+        if(profile_site)
+            profiler->exit(Builder, *profile_site);
 
         if(func_returns)
         {
@@ -1147,6 +1670,14 @@ namespace vire
             Builder.CreateRetVoid();
         }
 
+        promoteLocals(function);
+
+        if(debug_info)
+        {
+            debug_info->endFunction();
+            Builder.SetCurrentDebugLocation(llvm::DebugLoc());
+        }
+
         if(func->getIName().name=="main")
         {
             function->removeFnAttr("wasm-export-name");
@@ -1175,11 +1706,9 @@ namespace vire
 
         std::vector<llvm::Type*> elements;
 
-        auto const& vec=st->getMembersValues();
-        std::vector<ExprAST*>::const_reverse_iterator it;
-        for(it=vec.rbegin(); it!=vec.rend(); ++it)
+        // Members are laid out in declaration order, the same as a C struct with the same members
+        for(auto const& expr : st->getMembersValues())
         {
-            auto const& expr=*it;
             if(expr->asttype==ast_struct)
             {
                 auto* st=compileStruct("", ((StructExprAST*)expr));
@@ -1197,13 +1726,28 @@ namespace vire
 
         definedStructs[st->getName()]=struct_type;
 
-        // Create the constructor
-        compileFunction(st->getConstructor());
+        // Create the constructor, the constructor of an imported struct is defined in its own module
+        if(st->isImported())
+            compilePrototype(st->getConstructor()->getProto());
+        else
+            compileFunction(st->getConstructor());
 
         return struct_type;
     }
     llvm::Value* VCompiler::compileTypeAccess(TypeAccessAST* const expr)
     {
+        // Fields of a scalarized struct are plain locals
+        if(expr->getParent()->asttype==ast_var && expr->getChild()->asttype==ast_var)
+        {
+            auto split=scalarizedStructs.find(((VariableExprAST*)expr->getParent())->getName());
+            if(split!=scalarizedStructs.end())
+            {
+                auto* st=analyzer->getStruct(((types::Custom*)expr->getParent()->getType())->getName());
+                auto* field=split->second[st->getMemberIndex(expr->getIName())];
+                return Builder.CreateLoad(field->getAllocatedType(), field);
+            }
+        }
+
         llvm::Value* sgep=nullptr;
         StructExprAST* st=nullptr;
         ExprAST* current_expr=expr;
@@ -1272,16 +1816,48 @@ namespace vire
     void VCompiler::resetModule()
     {
         Module=std::make_unique<llvm::Module>(Module->getName(), CTX);
+        Module->setDataLayout(*data_layout);
+        if(target_machine)
+        {
+            Module->setTargetTriple(llvm::Triple(target_machine_triple));
+        }
+    }
+    void VCompiler::resetAnalyzer(std::unique_ptr<VAnalyzer> new_analyzer)
+    {
+        analyzer=std::move(new_analyzer);
+        escape=VEscapeAnalysis(analyzer.get());
+        reachability=VReachability(analyzer.get());
+
+        namedValues.clear();
+        definedStructs.clear();
+        scalarizedStructs.clear();
+        output_ir.clear();
+
+        resetModule();
     }
     void VCompiler::compileModule()
     {
         auto* mod=analyzer->getSourceModule();
 
+        debug_info.reset();
+        if(debug_info_kind!=DebugInfo::None)
+            debug_info=std::make_unique<VDebugInfo>(this, *Module, debug_info_kind, debug_source_path, debug_lines);
+
+        profiler.reset();
+        if(instrument)
+            profiler=std::make_unique<VProfiler>(*Module);
+
+        // Unused functions and structs are skipped, they would only cost codegen and optimization time
+        reachability.analyze(mod);
+
         for(auto const& s:mod->getUnionStructs())
         {
             if(s->asttype==ast_struct)
             {
                 std::string name=((StructExprAST*)s.get())->getName();
+                if(!reachability.isStructReachable(name))
+                    continue;
+
                 compileStruct(name);
             }
             else
@@ -1293,6 +1869,11 @@ namespace vire
 
         for(auto const& f:mod->getFunctions())
         {
+            if(!reachability.isFunctionReachable(f.get()))
+            {
+                continue;
+            }
+
             if(f->is_proto())
             {
                 auto* proto=(PrototypeAST*)f.get();
@@ -1309,6 +1890,14 @@ namespace vire
             }
         }
 
+        // A module of only declarations is a library imported by other modules, they provide `main`
+        if(!Module->getFunction("entry_main") && mod->getPreExecutionStatements().empty())
+        {
+            if(debug_info)
+                debug_info->finalize();
+            return;
+        }
+
         current_func_single_sret=current_func_ret_ty=false;
         llvm::FunctionType* main_type=llvm::FunctionType::get(llvm::Type::getInt32Ty(CTX), false);
         llvm::Function* main_func=llvm::Function::Create(main_type, llvm::GlobalValue::ExternalLinkage, "main", Module.get());
@@ -1326,7 +1915,14 @@ namespace vire
 
         auto main_func_ast=std::make_unique<FunctionAST>(std::make_unique<PrototypeAST>(std::move(name), std::move(args), types::construct("int")), std::move(stms));
         currentFunctionAST=main_func_ast.get();
+
+        if(debug_info)
+        {
+            debug_info->beginFunction(main_func, main_func_ast.get(), 0);
+            Builder.SetCurrentDebugLocation(debug_info->getLocation(0));
+        }
         
+        escape.analyze(mod->getPreExecutionStatements());
         for(auto const& var: mod->getPreExecutionStatementsVariables())
         {
             createAllocaForVar(var);
@@ -1360,6 +1956,14 @@ namespace vire
             Builder.SetInsertPoint(currentFunctionEndBB);
             Builder.CreateRet(llvm::ConstantInt::get(CTX, llvm::APInt(32, 0, false)));
         }
+
+        promoteLocals(main_func);
+
+        if(debug_info)
+        {
+            debug_info->finalize();
+            Builder.SetCurrentDebugLocation(llvm::DebugLoc());
+        }
     }
 
     llvm::Module* const VCompiler::getModule() const
@@ -1378,68 +1982,119 @@ namespace vire
         return analyzer.get();
     }
 
-    void VCompiler::runOptimizationPasses(llvm::TargetMachine* tm, Optimization opt_level, bool enable_lto)
+#ifndef VIRE_NO_PASSES
+    // OptimizationPipeline - The analysis managers and the pass manager for one target machine and optimization level
+    struct OptimizationPipeline
     {
-        #ifndef VIRE_NO_PASSES
-        
+        llvm::TargetMachine* tm;
+        Optimization opt_level;
+        bool enable_lto;
+
         llvm::LoopAnalysisManager lam;
         llvm::FunctionAnalysisManager fam;
         llvm::CGSCCAnalysisManager cam;
         llvm::ModuleAnalysisManager mam;
 
-        llvm::PipelineTuningOptions pio;
-        pio.LoopInterleaving=true;
-        pio.LoopUnrolling=true;
-        pio.LoopVectorization=true;
-        pio.SLPVectorization=true;
-        pio.MergeFunctions=true;
-        llvm::PassBuilder pass_builder(tm, pio);
-
-        fam.registerPass([&] { return pass_builder.buildDefaultAAPipeline(); });
-        pass_builder.registerModuleAnalyses(mam);
-        pass_builder.registerCGSCCAnalyses(cam);
-        pass_builder.registerFunctionAnalyses(fam);
-        pass_builder.registerLoopAnalyses(lam);
-        pass_builder.crossRegisterProxies(lam, fam, cam, mam);
-
-        pass_builder.registerOptimizerLastEPCallback([&] (llvm::ModulePassManager& mpm, llvm::OptimizationLevel level, llvm::ThinOrFullLTOPhase phase)
-        {
-            mpm.addPass(llvm::createModuleToFunctionPassAdaptor(llvm::DSEPass{}));
-        });
-
+        llvm::PassBuilder pass_builder;
         llvm::ModulePassManager passmgr;
-        llvm::OptimizationLevel lvl;
 
-        if(opt_level == Optimization::O0)
+        static llvm::PipelineTuningOptions getTuningOptions()
         {
-            auto lto_phase = enable_lto ? llvm::ThinOrFullLTOPhase::FullLTOPreLink : llvm::ThinOrFullLTOPhase::None;
-    
-            passmgr = pass_builder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0, lto_phase);
+            llvm::PipelineTuningOptions pio;
+            pio.LoopInterleaving=true;
+            pio.LoopUnrolling=true;
+            pio.LoopVectorization=true;
+            pio.SLPVectorization=true;
+            pio.MergeFunctions=true;
+            return pio;
         }
-        else
+
+        OptimizationPipeline(llvm::TargetMachine* tm, Optimization opt_level, bool enable_lto)
+        : tm(tm), opt_level(opt_level), enable_lto(enable_lto), pass_builder(tm, getTuningOptions())
         {
-            switch(opt_level)
+            fam.registerPass([this] { return pass_builder.buildDefaultAAPipeline(); });
+            pass_builder.registerModuleAnalyses(mam);
+            pass_builder.registerCGSCCAnalyses(cam);
+            pass_builder.registerFunctionAnalyses(fam);
+            pass_builder.registerLoopAnalyses(lam);
+            pass_builder.crossRegisterProxies(lam, fam, cam, mam);
+
+            pass_builder.registerOptimizerLastEPCallback([&] (llvm::ModulePassManager& mpm, llvm::OptimizationLevel level, llvm::ThinOrFullLTOPhase phase)
             {
-                case Optimization::O1: lvl=llvm::OptimizationLevel::O1; break;
-                case Optimization::O2: lvl=llvm::OptimizationLevel::O2; break;
-                case Optimization::O3: lvl=llvm::OptimizationLevel::O3; break;
-                case Optimization::Os: lvl=llvm::OptimizationLevel::Os; break;
-                case Optimization::Oz: lvl=llvm::OptimizationLevel::Oz; break;
+                mpm.addPass(llvm::createModuleToFunctionPassAdaptor(llvm::DSEPass{}));
+            });
 
-                default: lvl=llvm::OptimizationLevel::O0;
-            }
+            llvm::OptimizationLevel lvl;
 
-            if(enable_lto)
+            if(opt_level == Optimization::O0)
             {
-                passmgr=pass_builder.buildLTOPreLinkDefaultPipeline(lvl);
+                auto lto_phase = enable_lto ? llvm::ThinOrFullLTOPhase::FullLTOPreLink : llvm::ThinOrFullLTOPhase::None;
+        
+                passmgr = pass_builder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0, lto_phase);
             }
             else
             {
-                passmgr=pass_builder.buildPerModuleDefaultPipeline(lvl);
+                switch(opt_level)
+                {
+                    case Optimization::O1: lvl=llvm::OptimizationLevel::O1; break;
+                    case Optimization::O2: lvl=llvm::OptimizationLevel::O2; break;
+                    case Optimization::O3: lvl=llvm::OptimizationLevel::O3; break;
+                    case Optimization::Os: lvl=llvm::OptimizationLevel::Os; break;
+                    case Optimization::Oz: lvl=llvm::OptimizationLevel::Oz; break;
+
+                    default: lvl=llvm::OptimizationLevel::O0;
+                }
+
+                if(enable_lto)
+                {
+                    passmgr=pass_builder.buildLTOPreLinkDefaultPipeline(lvl);
+                }
+                else
+                {
+                    passmgr=pass_builder.buildPerModuleDefaultPipeline(lvl);
+                }
             }
         }
 
-        passmgr.run(*Module, mam);
+        // Analysis results point into the module that was optimized, they are dropped before the next one
+        void clear()
+        {
+            lam.clear();
+            fam.clear();
+            cam.clear();
+            mam.clear();
+        }
+    };
+#else
+    struct OptimizationPipeline {};
+#endif
+
+    // Defined where `OptimizationPipeline` is complete
+    VCompiler::VCompiler(std::unique_ptr<VAnalyzer> analyzer, std::string const& name)
+    : analyzer(std::move(analyzer)), Builder(llvm::IRBuilder<>(CTX)), escape(this->analyzer.get()), reachability(this->analyzer.get())
+    {
+        Module = std::make_unique<llvm::Module>(name, CTX);
+        data_layout = std::make_unique<llvm::DataLayout>(Module->getDataLayoutStr());
+        file_type=llvm::CodeGenFileType::ObjectFile;
+    }
+    VCompiler::~VCompiler() = default;
+
+    void VCompiler::runOptimizationPasses(llvm::TargetMachine* tm, Optimization opt_level, bool enable_lto)
+    {
+        #ifndef VIRE_NO_PASSES
+
+        // Building the pipeline costs more than running it on a small module, it is kept while the options stay the same
+        if(!pipeline || pipeline->tm!=tm || pipeline->opt_level!=opt_level || pipeline->enable_lto!=enable_lto)
+        {
+            pipeline=std::make_unique<OptimizationPipeline>(tm, opt_level, enable_lto);
+        }
+
+        pipeline->passmgr.run(*Module, pipeline->mam);
+        pipeline->clear();
+
+        #else
+
+        runLiteOptimizationPasses(*Module, tm, opt_level);
 
         #endif
     }
@@ -1454,6 +2109,14 @@ namespace vire
         {
             target_triple=target_str;
         }
+
+        // The target machine of the previous module is reused for the same triple and relocation model
+        if(target_machine && target_machine_triple==target_triple && target_machine->isPositionIndependent()==position_independent)
+        {
+            Module->setDataLayout(*data_layout);
+            Module->setTargetTriple(llvm::Triple(target_triple));
+            return target_machine.get();
+        }
     
     #ifdef VIRE_ENABLE_ONLY
         SPECIFIC_INIT_TARGET_INFO(VIRE_ENABLE_ONLY);
@@ -1489,37 +2152,70 @@ namespace vire
 
         llvm::TargetOptions opt;
         auto rm=std::optional<llvm::Reloc::Model>();
+        if(position_independent)
+            rm=llvm::Reloc::PIC_;
+
+        target_machine.reset(target->createTargetMachine(llvm::Triple(target_triple), cpu, features, opt, rm));
+        target_machine_triple=target_triple;
 
-        auto* target_machine=target->createTargetMachine(llvm::Triple(target_triple), cpu, features, opt, rm);
+        // Layouts computed for the previous target do not apply anymore
+        data_layout=std::make_unique<llvm::DataLayout>(target_machine->createDataLayout());
+        typeLayouts.clear();
 
-        Module->setDataLayout(target_machine->createDataLayout());
+        Module->setDataLayout(*data_layout);
         Module->setTargetTriple(llvm::Triple(target_triple));
 
-        return target_machine;
+        return target_machine.get();
+    }
+    bool VCompiler::setTarget(std::string const& target_str)
+    {
+        return compileInternal(target_str)!=nullptr;
+    }
+    void VCompiler::setPositionIndependent(bool enable)
+    {
+        position_independent=enable;
+    }
+    void VCompiler::setInstrumentation(bool enable)
+    {
+        instrument=enable;
+    }
+    void VCompiler::setDebugInfo(DebugInfo kind)
+    {
+        debug_info_kind=kind;
+    }
+    void VCompiler::setDebugSource(std::string const& path, std::string_view source)
+    {
+        debug_source_path=path;
+
+        // Without debug info the lines are never looked up, the source is not scanned
+        if(debug_info_kind==DebugInfo::None)
+        {
+            debug_lines.clear();
+            return;
+        }
+        debug_lines.build(source);
     }
     std::vector<unsigned char> VCompiler::compileToString(std::string const& target_str, Optimization opt_level, bool enable_lto)
     {
         llvm::SmallString<1> out;
         llvm::raw_svector_ostream os(out);
 
-        auto* target_machine=compileInternal(target_str);
+        auto* tm=compileInternal(target_str);
 
-        if(!target_machine)
+        if(!tm)
         {
             return std::vector<unsigned char>();
         }
 
-        runOptimizationPasses(target_machine, opt_level, enable_lto);
+        runOptimizationPasses(tm, opt_level, enable_lto);
 
         llvm::legacy::PassManager legacy_passmgr;
-        target_machine->addPassesToEmitFile(legacy_passmgr, os, nullptr, file_type);
+        tm->addPassesToEmitFile(legacy_passmgr, os, nullptr, file_type);
         legacy_passmgr.run(*Module);
 
         auto bytestr=out.str().str();
         std::vector<unsigned char> ret(bytestr.begin(), bytestr.end());
 
-        delete target_machine;
-
         return ret;
     }
     void VCompiler::compileToFile(std::string const& filename, std::string const& target_str, Optimization opt_level, bool enable_lto)
@@ -1527,20 +2223,18 @@ namespace vire
         std::error_code ec;
         llvm::raw_fd_ostream os(filename, ec, llvm::sys::fs::OF_None);
         
-        auto* target_machine=compileInternal(target_str);
+        auto* tm=compileInternal(target_str);
 
-        if(!target_machine)
+        if(!tm)
         {
             return;
         }
 
-        runOptimizationPasses(target_machine, opt_level, enable_lto);
+        runOptimizationPasses(tm, opt_level, enable_lto);
 
         llvm::legacy::PassManager legacy_passmgr;
-        target_machine->addPassesToEmitFile(legacy_passmgr, os, nullptr, file_type);
+        tm->addPassesToEmitFile(legacy_passmgr, os, nullptr, file_type);
         legacy_passmgr.run(*Module);
         os.flush();
-
-        delete target_machine;
     }
 }
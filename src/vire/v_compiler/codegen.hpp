@@ -6,6 +6,10 @@
 
 #include "vire/ast/include.hpp"
 #include "vire/v_analyzer/include.hpp"
+#include "escape.hpp"
+#include "reachability.hpp"
+#include "debuginfo.hpp"
+#include "profile.hpp"
 
 // For `VIRE_ENABLE_ONLY` definition
 #include "vire/config/config.hpp"
@@ -37,11 +41,23 @@ namespace llvm
 
 #include <memory>
 #include <map>
+#include <unordered_set>
+#include <unordered_map>
 #include <string>
+#include <cstdint>
 
 namespace vire
 {
 
+struct OptimizationPipeline;
+
+// TypeLayout - Size and ABI alignment in bytes of a type on the compilation target
+struct TypeLayout
+{
+    std::uint64_t size;
+    std::uint64_t align;
+};
+
 class VCompiler
 {
     std::unique_ptr<VAnalyzer> analyzer;
@@ -55,6 +71,10 @@ class VCompiler
     // Memory
     std::map<llvm::StringRef, llvm::AllocaInst*> namedValues;
     std::map<std::string, llvm::StructType*> definedStructs;
+    std::map<std::string, std::vector<llvm::AllocaInst*>> scalarizedStructs;
+    std::unordered_map<llvm::Type*, TypeLayout> typeLayouts; // computed from `data_layout`, cleared when it changes
+    VEscapeAnalysis escape;
+    VReachability reachability;
     llvm::Function* currentFunction;
     llvm::BasicBlock* currentFunctionEndBB;
     llvm::BasicBlock* currentLoopEndBB;
@@ -66,28 +86,45 @@ class VCompiler
     // Compilation
     enum llvm::CodeGenFileType file_type;
     std::string output_ir;
+
+    // Created on first use and reused for every module this compiler emits
+    std::unique_ptr<llvm::TargetMachine> target_machine;
+    std::string target_machine_triple;
+    bool position_independent=false;
+    std::unique_ptr<OptimizationPipeline> pipeline;
+
+    // Debug info, nothing is emitted with `DebugInfo::None`
+    DebugInfo debug_info_kind=DebugInfo::None;
+    std::string debug_source_path;
+    DebugLines debug_lines;
+    std::unique_ptr<VDebugInfo> debug_info; // of the module being compiled
+
+    // Profiling instrumentation, off by default
+    bool instrument=false;
+    std::unique_ptr<VProfiler> profiler; // of the module being compiled
 private:
     llvm::TargetMachine* compileInternal(std::string const& target_str);
     void runOptimizationPasses(llvm::TargetMachine* tm, Optimization opt_level=Optimization::O0, bool enable_lto=false);
+    VProfiler::Site createLoopProfileSite(ExprAST* const loop, std::string const& kind);
 
 public:
-    VCompiler(std::unique_ptr<VAnalyzer> analyzer, std::string const& name="vire")
-    : analyzer(std::move(analyzer)), Builder(llvm::IRBuilder<>(CTX))
-    {
-        Module = std::make_unique<llvm::Module>(name, CTX);
-        data_layout = std::make_unique<llvm::DataLayout>(Module->getDataLayoutStr());
-        file_type=llvm::CodeGenFileType::ObjectFile;
-    }
+    VCompiler(std::unique_ptr<VAnalyzer> analyzer, std::string const& name="vire");
+    ~VCompiler();
 
     // Compilation Functions
     
     llvm::Type* getLLVMType(types::Base* type, bool allow_opaque_ptr=true);
+    TypeLayout const& getTypeLayout(types::Base* type);
 
     void createSRetMemCpyForArg(ReturnExprAST* ret);
     llvm::CallInst* pushFrontToCallInst(llvm::Value* arg, llvm::CallInst* call);
+    llvm::CallInst* compileCallIntoSRet(CallExprAST* const call, llvm::Value* dest);
     llvm::Value* createAllocaForVar(VariableDefAST* const& var);
+    void promoteLocals(llvm::Function* func);
     llvm::Value* createBinaryOperation(llvm::Value* lhs, llvm::Value* rhs, VToken* const op, bool expr_is_fp);
     llvm::BranchInst* createBrIfNoTerminator(llvm::BasicBlock* block);
+    void attachLoopHints(llvm::BasicBlock* header, llvm::BasicBlock* preheader, LoopHints const& hints);
+    llvm::Function* createParallelRangeFunction(llvm::Function* outlined, llvm::StructType* ctx_type, LoopHints const& hints);
     llvm::Value* getValueAsAlloca(llvm::Value* value);
     llvm::Value* getOrigin(llvm::Value* value);
 
@@ -119,11 +156,13 @@ public:
     llvm::Value* compileIfElse(IfExprAST* const ifelse);
 
     llvm::Value* compileForExpr(ForExprAST* const forexpr);
+    llvm::Value* compileParallelForExpr(ForExprAST* const forexpr);
     llvm::Value* compileWhileExpr(WhileExprAST* const whileexpr);
     llvm::Value* compileBreakExpr(BreakExprAST* const breakexpr);
     llvm::Value* compileContinueExpr(ContinueExprAST* const continueexpr);
 
     llvm::Value* compileCallExpr(CallExprAST* const expr, llvm::Value* parent_struct=nullptr);
+    llvm::Value* compileBuiltinCall(CallExprAST* const expr);
     llvm::Value* compileReturnExpr(ReturnExprAST* const expr);
     llvm::Function* compilePrototype(PrototypeAST* const proto);
     llvm::Function* compileExtern(std::string const& name);
@@ -139,6 +178,18 @@ public:
     VAnalyzer* const getAnalyzer()  const;
     
     void resetModule();
+    // Compiles the module of another source, the context, target machine and pass pipeline are kept
+    void resetAnalyzer(std::unique_ptr<VAnalyzer> new_analyzer);
+    // Selects the target before `compileModule`, sizes and alignments in the IR follow its data layout
+    bool setTarget(std::string const& target_str);
+    // Code loaded at any address, eg - by a JIT, the default relocation model of the target is used otherwise
+    void setPositionIndependent(bool enable);
+    // Emits DWARF line tables, or with `DebugInfo::Full` also types and variables, for the next `compileModule`
+    void setDebugInfo(DebugInfo kind);
+    // The file and source the locations refer to, the source is only read with debug info enabled
+    void setDebugSource(std::string const& path, std::string_view source);
+    // Times every function and loop of the next `compileModule`, the program has to be linked with libvirert
+    void setInstrumentation(bool enable);
     void compileModule();
     void compileToFile(std::string const& filename, std::string const& target, Optimization opt_level=Optimization::O0, bool enable_lto=false);
     std::vector<unsigned char> compileToString(std::string const& target_str="", Optimization opt_level=Optimization::O0, bool enable_lto=false);
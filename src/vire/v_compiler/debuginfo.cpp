@@ -0,0 +1,209 @@
+#include "debuginfo.hpp"
+#include "codegen.hpp"
+
+#include "llvm/BinaryFormat/Dwarf.h"
+
+#include <filesystem>
+
+namespace vire
+{
+    void DebugLines::build(std::string_view source)
+    {
+        file_lines.assign(1, 1);
+
+        std::uint32_t file_line=1;
+        for(std::size_t i=0; i<source.size(); i++)
+        {
+            char c=source[i];
+            if(c!='\n' && c!='\r')
+                continue;
+
+            // The '\n' of "\r\n" starts a line of the lexer but not one of the file
+            if(c=='\r' || i==0 || source[i-1]!='\r')
+                file_line++;
+            file_lines.push_back(file_line);
+        }
+    }
+
+    VDebugInfo::VDebugInfo(VCompiler* compiler, llvm::Module& module, DebugInfo kind, std::string const& source_path, DebugLines const& lines)
+    : compiler(compiler), module(module), kind(kind), lines(lines), builder(std::make_unique<llvm::DIBuilder>(module)), scope(nullptr)
+    {
+        auto path=std::filesystem::path(source_path.empty() ? module.getName().str() : source_path);
+        auto directory=path.parent_path().string();
+        file=builder->createFile(path.filename().string(), directory.empty() ? "." : directory);
+
+        auto emission=kind==DebugInfo::Full ? llvm::DICompileUnit::FullDebug : llvm::DICompileUnit::LineTablesOnly;
+        unit=builder->createCompileUnit(llvm::dwarf::DW_LANG_C, file, "vire", false, "", 0, "", emission);
+
+        if(!module.getModuleFlag("Debug Info Version"))
+            module.addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+        if(!module.getModuleFlag("Dwarf Version"))
+            module.addModuleFlag(llvm::Module::Warning, "Dwarf Version", 5);
+    }
+
+    llvm::DIType* VDebugInfo::getType(types::Base* const type)
+    {
+        auto it=types.find(type);
+        if(it!=types.end())
+            return it->second;
+
+        llvm::DIType* di_type=nullptr;
+        switch(type->getType())
+        {
+            case types::EType::Bool:    di_type=builder->createBasicType("bool", 8, llvm::dwarf::DW_ATE_boolean); break;
+            case types::EType::Char:    di_type=builder->createBasicType("char", 8, llvm::dwarf::DW_ATE_signed_char); break;
+            case types::EType::Short:   di_type=builder->createBasicType("short", 16, llvm::dwarf::DW_ATE_signed); break;
+            case types::EType::Int:     di_type=builder->createBasicType("int", 32, llvm::dwarf::DW_ATE_signed); break;
+            case types::EType::Long:    di_type=builder->createBasicType("long", 64, llvm::dwarf::DW_ATE_signed); break;
+            case types::EType::Float:   di_type=builder->createBasicType("float", 32, llvm::dwarf::DW_ATE_float); break;
+            case types::EType::Double:  di_type=builder->createBasicType("double", 64, llvm::dwarf::DW_ATE_float); break;
+            case types::EType::Array:
+            {
+                auto* array=(types::Array*)type;
+                auto* llvm_type=compiler->getLLVMType(type, false);
+                auto const& layout=module.getDataLayout();
+
+                auto* subscript=builder->getOrCreateSubrange(0, (std::int64_t)array->getLength());
+                di_type=builder->createArrayType(layout.getTypeAllocSizeInBits(llvm_type), layout.getABITypeAlign(llvm_type).value()*8,
+                    getType(array->getChild()), builder->getOrCreateArray({subscript}));
+                break;
+            }
+            case types::EType::Custom:
+                di_type=createStructType((types::Custom*)type);
+                break;
+
+            // `void` is described by the absence of a type
+            default: break;
+        }
+
+        return types[type]=di_type;
+    }
+
+    llvm::DIType* VDebugInfo::createStructType(types::Custom* const type)
+    {
+        auto const& name=type->getName();
+        auto* analyzer=compiler->getAnalyzer();
+        auto* st=analyzer->isStructDefined(name) ? analyzer->getStruct(name) : nullptr;
+        auto* llvm_type=llvm::dyn_cast_or_null<llvm::StructType>(compiler->getLLVMType(type, false));
+
+        // Nested structs are only known to their parent, they are left undescribed
+        if(!st || !llvm_type || llvm_type->isOpaque())
+            return builder->createForwardDecl(llvm::dwarf::DW_TAG_structure_type, name, unit, file, 0);
+
+        auto const& layout=module.getDataLayout();
+        auto* struct_layout=layout.getStructLayout(llvm_type);
+        auto line=st->getNameToken() ? lines.getFileLine(st->getNameToken()->line) : 0;
+
+        auto* di_struct=builder->createStructType(unit, name, file, line, struct_layout->getSizeInBits(), struct_layout->getAlignment().value()*8,
+            llvm::DINode::FlagZero, nullptr, llvm::DINodeArray());
+        types[type]=di_struct;
+
+        std::vector<llvm::Metadata*> elements;
+        for(auto const& iname : st->getMembersOrder())
+        {
+            auto* member=st->getMember(iname);
+            auto indx=st->getMemberIndex(iname);
+            auto* element_type=llvm_type->getElementType(indx);
+
+            auto* token=member->asttype==ast_struct ? ((StructExprAST*)member)->getNameToken() : member->getToken();
+            elements.push_back(builder->createMemberType(di_struct, iname.name, file, token ? lines.getFileLine(token->line) : line,
+                layout.getTypeAllocSizeInBits(element_type), layout.getABITypeAlign(element_type).value()*8,
+                struct_layout->getElementOffsetInBits(indx), llvm::DINode::FlagZero, getType(member->getType())));
+        }
+        builder->replaceArrays(di_struct, builder->getOrCreateArray(elements));
+        return di_struct;
+    }
+
+    llvm::DISubroutineType* VDebugInfo::createFunctionType(FunctionBaseAST* const func)
+    {
+        // The first entry is the return type
+        std::vector<llvm::Metadata*> signature;
+        if(isFull())
+        {
+            signature.push_back(func->isConstructor() ? nullptr : getType(func->getReturnType()));
+            for(auto const& arg : func->getArgs())
+            {
+                signature.push_back(getType(arg->getType()));
+            }
+        }
+        return builder->createSubroutineType(builder->getOrCreateTypeArray(signature));
+    }
+
+    void VDebugInfo::beginFunction(llvm::Function* function, FunctionBaseAST* const func, std::size_t line)
+    {
+        auto file_line=lines.getFileLine(line);
+        scope=builder->createFunction(file, function->getName(), llvm::StringRef(), file, file_line, createFunctionType(func), file_line,
+            llvm::DINode::FlagPrototyped, llvm::DISubprogram::SPFlagDefinition);
+        function->setSubprogram(scope);
+    }
+    void VDebugInfo::endFunction()
+    {
+        if(scope)
+            builder->finalizeSubprogram(scope);
+        scope=nullptr;
+    }
+    llvm::DebugLoc VDebugInfo::describeArtificialFunction(llvm::Function* function, llvm::DebugLoc const& at)
+    {
+        auto line=at ? at.getLine() : 0;
+        auto* subprogram=builder->createFunction(file, function->getName(), llvm::StringRef(), file, line,
+            builder->createSubroutineType(builder->getOrCreateTypeArray({})), line, llvm::DINode::FlagArtificial,
+            llvm::DISubprogram::SPFlagDefinition | llvm::DISubprogram::SPFlagLocalToUnit);
+        function->setSubprogram(subprogram);
+        builder->finalizeSubprogram(subprogram);
+
+        return llvm::DILocation::get(module.getContext(), line, 0, subprogram);
+    }
+
+    llvm::DebugLoc VDebugInfo::getLocation(std::size_t line) const
+    {
+        if(!scope)
+            return llvm::DebugLoc();
+        return llvm::DILocation::get(module.getContext(), lines.getFileLine(line), 0, scope);
+    }
+    VToken* const VDebugInfo::getLineToken(ExprAST* const expr)
+    {
+        if(auto* token=expr->getToken())
+            return token;
+        if(expr->asttype==ast_binop)
+            return ((BinaryExprAST*)expr)->getOp();
+
+        VToken* token=nullptr;
+        forEachChild(expr, [&token](ExprAST* child)
+        {
+            if(!token)
+                token=getLineToken(child);
+        });
+        return token;
+    }
+
+    void VDebugInfo::declareVariable(VariableDefAST* const var, llvm::Value* storage, llvm::BasicBlock* block)
+    {
+        if(!isFull() || !scope || !var->getToken())
+            return;
+
+        auto line=lines.getFileLine(var->getToken()->line);
+        auto* variable=builder->createAutoVariable(scope, var->getName(), file, line, getType(var->getType()), true);
+        builder->insertDeclare(storage, variable, builder->createExpression(), llvm::DILocation::get(module.getContext(), line, 0, scope), block);
+    }
+    void VDebugInfo::declareArgument(VariableDefAST* const var, unsigned int arg_no, llvm::Value* value, llvm::BasicBlock* block)
+    {
+        if(!isFull() || !scope)
+            return;
+
+        auto line=var->getToken() ? lines.getFileLine(var->getToken()->line) : scope->getLine();
+        auto* variable=builder->createParameterVariable(scope, var->getName(), arg_no, file, line, getType(var->getType()), true);
+        auto* location=llvm::DILocation::get(module.getContext(), line, 0, scope);
+
+        // Structs, arrays and references are passed as their address
+        if(value->getType()->isPointerTy())
+            builder->insertDeclare(value, variable, builder->createExpression(), location, block);
+        else
+            builder->insertDbgValueIntrinsic(value, variable, builder->createExpression(), location, block);
+    }
+
+    void VDebugInfo::finalize()
+    {
+        endFunction();
+        builder->finalize();
+    }
+}
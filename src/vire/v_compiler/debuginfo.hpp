@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vire/ast/include.hpp"
+#include "vire/config/config.hpp"
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/DebugLoc.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+namespace vire
+{
+
+class VCompiler;
+
+// DebugLines - Maps the lines of the lexer to the lines of the source file
+// The lexer starts a line at every '\n' and '\r', so a "\r\n" file would otherwise be off by a line per line
+class DebugLines
+{
+    std::vector<std::uint32_t> file_lines; // by lexer line, 1-based file lines
+public:
+    void build(std::string_view source);
+    void clear() { file_lines.clear(); }
+
+    std::uint32_t getFileLine(std::size_t lexer_line) const
+    {
+        if(lexer_line<file_lines.size())
+            return file_lines[lexer_line];
+        return lexer_line+1;
+    }
+};
+
+// VDebugInfo - The DWARF metadata of one module, created by `compileModule` when debug info is enabled
+// Line tables only need a subprogram per function and a location per expression,
+// `DebugInfo::Full` also describes the types, arguments and locals
+// Token columns are not exact, locations only carry the line
+class VDebugInfo
+{
+    VCompiler* compiler;
+    llvm::Module& module;
+    DebugInfo kind;
+    DebugLines const& lines;
+
+    std::unique_ptr<llvm::DIBuilder> builder;
+    llvm::DICompileUnit* unit;
+    llvm::DIFile* file;
+    llvm::DISubprogram* scope; // of the function being compiled, nullptr outside of one
+
+    std::unordered_map<types::Base*, llvm::DIType*> types; // types are hash-consed, the pointer is the key
+
+    llvm::DIType* createStructType(types::Custom* const type);
+    llvm::DISubroutineType* createFunctionType(FunctionBaseAST* const func);
+public:
+    VDebugInfo(VCompiler* compiler, llvm::Module& module, DebugInfo kind, std::string const& source_path, DebugLines const& lines);
+
+    bool isFull() const { return kind==DebugInfo::Full; }
+
+    // Gives `function` its subprogram, locations are in it until `endFunction`
+    void beginFunction(llvm::Function* function, FunctionBaseAST* const func, std::size_t line);
+    void endFunction();
+    // Gives a function the compiler made up a subprogram of its own, returns the location of its instructions
+    llvm::DebugLoc describeArtificialFunction(llvm::Function* function, llvm::DebugLoc const& at);
+
+    // An empty location outside of a function
+    llvm::DebugLoc getLocation(std::size_t line) const;
+    // The token an expression is located at, operators and statements without one take the first of their children
+    static VToken* const getLineToken(ExprAST* const expr);
+
+    llvm::DIType* getType(types::Base* const type);
+
+    // `storage` is the address of the variable, `value` the value of an argument passed in a register
+    void declareVariable(VariableDefAST* const var, llvm::Value* storage, llvm::BasicBlock* block);
+    void declareArgument(VariableDefAST* const var, unsigned int arg_no, llvm::Value* value, llvm::BasicBlock* block);
+
+    void finalize();
+};
+
+// DebugLocationScope - Sets the location of the instructions of one expression, the parent's is restored after it
+class DebugLocationScope
+{
+    llvm::IRBuilderBase& builder;
+    llvm::DebugLoc parent;
+public:
+    DebugLocationScope(llvm::IRBuilderBase& builder, llvm::DebugLoc location)
+    : builder(builder), parent(builder.getCurrentDebugLocation())
+    {
+        builder.SetCurrentDebugLocation(std::move(location));
+    }
+    ~DebugLocationScope() { builder.SetCurrentDebugLocation(parent); }
+
+    DebugLocationScope(DebugLocationScope const&)=delete;
+    DebugLocationScope& operator=(DebugLocationScope const&)=delete;
+};
+
+}
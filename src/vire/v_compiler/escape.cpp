@@ -0,0 +1,126 @@
+#include "escape.hpp"
+
+namespace vire
+{
+    void VEscapeAnalysis::visit(ExprAST* const expr)
+    {
+        switch(expr->asttype)
+        {
+            case ast_var:
+            {
+                // The whole value is used, eg - passed to a function, copied or returned
+                escaping.insert(((VariableExprAST*)expr)->getName());
+                return;
+            }
+            case ast_type_access:
+            {
+                auto* access=(TypeAccessAST*)expr;
+                if(access->getParent()->asttype==ast_var)
+                {
+                    // Member access does not need the address of the struct, method calls get it as `self`
+                    if(access->getChild()->asttype==ast_call)
+                    {
+                        escaping.insert(((VariableExprAST*)access->getParent())->getName());
+                        visit(access->getChild());
+                    }
+                    return;
+                }
+                break;
+            }
+            case ast_vardef:
+            {
+                auto* var=(VariableDefAST*)expr;
+                auto* value=var->getValue();
+
+                // Only a trivial constructor can be inlined as stores to the fields
+                if(value)
+                {
+                    bool is_trivial_init=(value->asttype==ast_call && ((CallExprAST*)value)->getBuiltin()==builtin_none
+                    && isTrivialConstructor(analyzer->getFunction(((CallExprAST*)value)->getIName().name)));
+
+                    if(!is_trivial_init)
+                        escaping.insert(var->getName());
+                }
+                break;
+            }
+            default: break;
+        }
+
+        forEachChild(expr, [this](ExprAST* child) { visit(child); });
+    }
+
+    void VEscapeAnalysis::analyze(std::vector<std::unique_ptr<ExprAST>> const& body)
+    {
+        escaping.clear();
+        for(auto const& expr : body)
+        {
+            visit(expr.get());
+        }
+    }
+
+    bool VEscapeAnalysis::isEscaping(std::string const& name) const
+    {
+        return escaping.count(name)>0;
+    }
+    bool VEscapeAnalysis::isFlatStruct(types::Base* const type) const
+    {
+        if(!types::isUserDefined(type))
+            return false;
+        
+        auto* st=analyzer->getStruct(((types::Custom*)type)->getName());
+        if(!st)
+            return false;
+
+        for(auto const& member : st->getMembersValues())
+        {
+            if(member->asttype!=ast_vardef)
+                return false;
+
+            auto member_ty=member->getType()->getType();
+            if(member_ty==types::EType::Custom || member_ty==types::EType::Array)
+                return false;
+        }
+
+        return true;
+    }
+    bool VEscapeAnalysis::isTrivialConstructor(FunctionBaseAST* const func) const
+    {
+        if(!func || !func->isConstructor() || func->is_extern() || func->is_proto())
+            return false;
+        
+        // Every statement has to be `self.member = argument`
+        // The body of an imported constructor is not known, it is defined in another module
+        auto* ctor=(FunctionAST*)func;
+        if(ctor->getBody().empty())
+            return false;
+
+        for(auto const& stm : ctor->getBody())
+        {
+            if(stm->asttype!=ast_varassign)
+                return false;
+            
+            auto* assign=(VariableAssignAST*)stm.get();
+            if(assign->is_shorthand || assign->getLHS()->asttype!=ast_type_access || assign->getRHS()->asttype!=ast_var)
+                return false;
+
+            auto* member=(TypeAccessAST*)assign->getLHS();
+            if(member->getParent()->asttype!=ast_var || member->getChild()->asttype!=ast_var)
+                return false;
+            if(((VariableExprAST*)member->getParent())->getIName().name!="self")
+                return false;
+
+            auto const& arg_name=((VariableExprAST*)assign->getRHS())->getName();
+            if(!ctor->isVariableDefined(arg_name) || !ctor->getVariable(arg_name)->isArgument())
+                return false;
+        }
+
+        return true;
+    }
+    bool VEscapeAnalysis::canSplit(VariableDefAST* const var) const
+    {
+        if(var->isArgument() || var->isReturned())
+            return false;
+        
+        return isFlatStruct(var->getType()) && !isEscaping(var->getName());
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "vire/ast/include.hpp"
+#include "vire/v_analyzer/include.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+
+namespace vire
+{
+
+// VEscapeAnalysis - Finds the struct locals whose address never leaves the function,
+// the compiler gives every field of these its own scalar which is later promoted to a register
+class VEscapeAnalysis
+{
+    VAnalyzer* analyzer;
+    std::unordered_set<std::string> escaping;
+
+    void visit(ExprAST* const expr);
+public:
+    VEscapeAnalysis(VAnalyzer* analyzer) : analyzer(analyzer) {}
+
+    void analyze(std::vector<std::unique_ptr<ExprAST>> const& body);
+
+    bool isEscaping(std::string const& name) const;
+    bool isFlatStruct(types::Base* const type) const;
+    bool isTrivialConstructor(FunctionBaseAST* const func) const;
+    bool canSplit(VariableDefAST* const var) const;
+};
+
+}
@@ -0,0 +1,142 @@
+#include "jit.hpp"
+
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Object/SymbolSize.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <fstream>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+namespace vire
+{
+    bool VJit::createJit()
+    {
+        if(jit)
+            return true;
+
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+
+        auto created=llvm::orc::LLJITBuilder().create();
+        if(!created)
+        {
+            llvm::errs() << "JIT could not be created:\n" << llvm::toString(created.takeError()) << "\n";
+            return false;
+        }
+        jit=std::move(*created);
+
+        // Calls into the runtime resolve to the functions of this process
+        auto process=llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit->getDataLayout().getGlobalPrefix());
+        if(!process)
+        {
+            llvm::errs() << llvm::toString(process.takeError()) << "\n";
+            return false;
+        }
+        jit->getMainJITDylib().addGenerator(std::move(*process));
+        return true;
+    }
+
+    void VJit::exposeLocalFunctions(llvm::Module& module)
+    {
+        for(auto& func : module)
+        {
+            if(func.isDeclaration() || !func.hasLocalLinkage())
+                continue;
+
+            func.setLinkage(llvm::GlobalValue::ExternalLinkage);
+            func.setVisibility(llvm::GlobalValue::HiddenVisibility);
+        }
+    }
+
+    bool VJit::addObject(std::vector<unsigned char> const& object, std::string const& name)
+    {
+        if(object.empty() || !createJit())
+            return false;
+
+        auto buffer=llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef((char const*)object.data(), object.size()), name);
+
+        // The sizes are only in the symbol table of the object, the JIT keeps the addresses
+        if(perf_map)
+        {
+            auto file=llvm::object::ObjectFile::createObjectFile(buffer->getMemBufferRef());
+            if(!file)
+            {
+                llvm::errs() << llvm::toString(file.takeError()) << "\n";
+                return false;
+            }
+
+            for(auto const& [symbol, size] : llvm::object::computeSymbolSizes(**file))
+            {
+                auto type=symbol.getType();
+                auto flags=symbol.getFlags();
+                auto symbol_name=symbol.getName();
+                if(!type || !flags || !symbol_name)
+                {
+                    llvm::consumeError(type.takeError());
+                    llvm::consumeError(flags.takeError());
+                    llvm::consumeError(symbol_name.takeError());
+                    continue;
+                }
+
+                if(*type==llvm::object::SymbolRef::ST_Function && !(*flags & llvm::object::SymbolRef::SF_Undefined) && size)
+                    functions.push_back({symbol_name->str(), size});
+            }
+        }
+
+        if(auto err=jit->addObjectFile(std::move(buffer)))
+        {
+            llvm::errs() << "Object could not be added to the JIT:\n" << llvm::toString(std::move(err)) << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    void VJit::writePerfMap()
+    {
+    #ifndef _WIN32
+        if(functions.empty())
+            return;
+
+        // One `<start> <size> <name>` line per function, in hex
+        std::ofstream map("/tmp/perf-"+std::to_string(::getpid())+".map", std::ios::app);
+        for(auto const& func : functions)
+        {
+            // Functions left local to their object cannot be looked up, their samples stay unnamed, see `exposeLocalFunctions`
+            auto address=jit->lookup(func.name);
+            if(!address)
+            {
+                llvm::consumeError(address.takeError());
+                continue;
+            }
+            map << std::hex << address->getValue() << " " << func.size << " " << func.name << "\n";
+        }
+    #endif
+        functions.clear();
+    }
+
+    int VJit::runMain()
+    {
+        if(!jit)
+            return -1;
+
+        auto main_address=jit->lookup("main");
+        if(!main_address)
+        {
+            llvm::errs() << llvm::toString(main_address.takeError()) << "\n";
+            return -1;
+        }
+
+        // Linking happens on the first lookup, the addresses are final from here on
+        if(perf_map)
+            writePerfMap();
+
+        auto* main_func=main_address->toPtr<int(*)()>();
+        return main_func();
+    }
+}
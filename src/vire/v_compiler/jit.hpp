@@ -0,0 +1,45 @@
+#pragma once
+
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace vire
+{
+
+// VJit - Links the objects of `VCompiler::compileToString` into this process and runs their `main`
+// The objects are the ones an AOT build would link, so the same code is profiled either way
+// Runtime functions are looked up in the process, the host links all of libvirert and exports its symbols, eg - VIRELANG
+class VJit
+{
+    struct FunctionSymbol
+    {
+        std::string name;
+        std::uint64_t size;
+    };
+
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    std::vector<FunctionSymbol> functions; // defined by the added objects, not written to the perf map yet
+    bool perf_map=false;
+private:
+    bool createJit();
+    void writePerfMap();
+public:
+    // Appends an entry for every function of the added objects to `/tmp/perf-<pid>.map` before they run,
+    // `perf report` reads it to name the samples in JIT-ed code
+    void setPerfMap(bool enable) { perf_map=enable; }
+
+    // Gives the functions local to `module` hidden external linkage, so the JIT can find their addresses for the perf map
+    // The bodies of `@parallel` loops and their range wrappers are local, they are usually where the time goes
+    // Call it before the module is compiled, a local function that is not used any more is then kept
+    static void exposeLocalFunctions(llvm::Module& module);
+
+    bool addObject(std::vector<unsigned char> const& object, std::string const& name="vire");
+    // The return value of `main`, -1 if the objects cannot be linked
+    int runMain();
+};
+
+}
@@ -0,0 +1,178 @@
+#include "optimizer.hpp"
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/IR/PassInstrumentation.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/BasicAliasAnalysis.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/Mem2Reg.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/InstCombine/InstCombine.h"
+#include "llvm/Transforms/Scalar/SimplifyCFG.h"
+#include "llvm/Transforms/Scalar/ADCE.h"
+#include "llvm/ADT/SCCIterator.h"
+
+#include <vector>
+#include <unordered_map>
+
+namespace vire
+{
+    // Largest callee (in instructions) that is inlined at each level, 0 disables the inliner
+    static unsigned getInlineThreshold(Optimization opt_level)
+    {
+        switch(opt_level)
+        {
+            case Optimization::O2: return 60;
+            case Optimization::O3: return 120;
+            case Optimization::Os: return 25;
+            case Optimization::Oz: return 10;
+
+            default: return 0;
+        }
+    }
+
+    static unsigned countInstructions(llvm::Function const& func)
+    {
+        unsigned count=0;
+        for(auto const& bb : func)
+        {
+            count+=bb.size();
+        }
+        return count;
+    }
+
+    // The functions on a call cycle by the cycle they are on, functions that are not recursive are left out
+    static std::unordered_map<llvm::Function*, unsigned> findRecursiveFunctions(llvm::Module& module)
+    {
+        llvm::CallGraph graph(module);
+        std::unordered_map<llvm::Function*, unsigned> cycles;
+
+        unsigned cycle=0;
+        for(auto scc=llvm::scc_begin(&graph); !scc.isAtEnd(); ++scc, cycle++)
+        {
+            if(!scc.hasCycle())
+                continue;
+
+            for(auto* node : *scc)
+            {
+                if(auto* func=node->getFunction())
+                    cycles[func]=cycle;
+            }
+        }
+        return cycles;
+    }
+
+    static bool inlineSmallCalls(llvm::Module& module, unsigned threshold)
+    {
+        // A call within a cycle, directly or through other functions, would only unroll the recursion
+        auto cycles=findRecursiveFunctions(module);
+        auto is_recursive_call=[&cycles](llvm::Function* caller, llvm::Function* callee)
+        {
+            auto caller_it=cycles.find(caller);
+            auto callee_it=cycles.find(callee);
+            return caller_it!=cycles.end() && callee_it!=cycles.end() && caller_it->second==callee_it->second;
+        };
+
+        std::vector<llvm::CallBase*> calls;
+        for(auto& func : module)
+        {
+            for(auto& bb : func)
+            {
+                for(auto& inst : bb)
+                {
+                    auto* call=llvm::dyn_cast<llvm::CallBase>(&inst);
+                    if(!call)
+                        continue;
+
+                    auto* callee=call->getCalledFunction();
+                    if(!callee || callee->isDeclaration() || is_recursive_call(&func, callee))
+                        continue;
+                    if(callee->hasFnAttribute(llvm::Attribute::NoInline))
+                        continue;
+
+                    // `@inline` allows a larger callee, `@cold` callees stay out of line
+                    unsigned limit=threshold;
+                    if(callee->hasFnAttribute(llvm::Attribute::InlineHint))
+                        limit*=4;
+                    else if(callee->hasFnAttribute(llvm::Attribute::Cold))
+                        limit=0;
+
+                    if(callee->hasFnAttribute(llvm::Attribute::AlwaysInline) || countInstructions(*callee)<=limit)
+                        calls.push_back(call);
+                }
+            }
+        }
+
+        bool changed=false;
+        for(auto* call : calls)
+        {
+            llvm::InlineFunctionInfo ifi;
+            changed|=llvm::InlineFunction(*call, ifi).isSuccess();
+        }
+
+        return changed;
+    }
+
+    void runLiteOptimizationPasses(llvm::Module& module, llvm::TargetMachine* tm, Optimization opt_level)
+    {
+        if(opt_level==Optimization::O0)
+            return;
+
+        // Register only the analyses used by the passes below, instead of the whole PassBuilder
+        llvm::FunctionAnalysisManager fam;
+        llvm::ModuleAnalysisManager mam;
+
+        fam.registerPass([] { return llvm::PassInstrumentationAnalysis(); });
+        fam.registerPass([] { return llvm::DominatorTreeAnalysis(); });
+        fam.registerPass([] { return llvm::PostDominatorTreeAnalysis(); });
+        fam.registerPass([] { return llvm::AssumptionAnalysis(); });
+        fam.registerPass([] { return llvm::TargetLibraryAnalysis(); });
+        fam.registerPass([tm] { return tm ? tm->getTargetIRAnalysis() : llvm::TargetIRAnalysis(); });
+        fam.registerPass([] { return llvm::OptimizationRemarkEmitterAnalysis(); });
+        fam.registerPass([] { return llvm::BasicAA(); });
+        fam.registerPass([] 
+        { 
+            llvm::AAManager aa;
+            aa.registerFunctionAnalysis<llvm::BasicAA>();
+            return aa;
+        });
+        fam.registerPass([&mam] { return llvm::ModuleAnalysisManagerFunctionProxy(mam); });
+
+        mam.registerPass([] { return llvm::PassInstrumentationAnalysis(); });
+        mam.registerPass([&fam] { return llvm::FunctionAnalysisManagerModuleProxy(fam); });
+
+        llvm::FunctionPassManager fpm;
+        fpm.addPass(llvm::PromotePass());
+        fpm.addPass(llvm::InstCombinePass());
+        fpm.addPass(llvm::SimplifyCFGPass());
+        fpm.addPass(llvm::ADCEPass());
+
+        auto run_function_passes=[&]()
+        {
+            for(auto& func : module)
+            {
+                if(!func.isDeclaration())
+                    fpm.run(func, fam);
+            }
+        };
+
+        // Simplify the callees first so that more of them fit under the threshold
+        run_function_passes();
+
+        unsigned threshold=getInlineThreshold(opt_level);
+        if(threshold && inlineSmallCalls(module, threshold))
+        {
+            fam.clear();
+            run_function_passes();
+        }
+    }
+}
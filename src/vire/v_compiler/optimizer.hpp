@@ -0,0 +1,19 @@
+#pragma once
+
+// For `Optimization`
+#include "vire/config/config.hpp"
+
+namespace llvm
+{
+    class Module;
+    class TargetMachine;
+}
+
+namespace vire
+{
+
+// Small pipeline used when the PassBuilder is not available (`VIRE_NO_PASSES`, the WASM build),
+// mem2reg, instcombine, simplifycfg, dce and an inliner for small functions
+void runLiteOptimizationPasses(llvm::Module& module, llvm::TargetMachine* tm, Optimization opt_level);
+
+}
@@ -0,0 +1,49 @@
+#include "profile.hpp"
+
+namespace vire
+{
+    VProfiler::VProfiler(llvm::Module& module)
+    : module(module)
+    {
+        auto& ctx=module.getContext();
+        auto* ptr_ty=llvm::PointerType::get(ctx, 0);
+        auto* void_ty=llvm::Type::getVoidTy(ctx);
+
+        // void vire_profile_enter(vire_profile_site** site, const char* name), void vire_profile_exit(vire_profile_site** site)
+        enter_func=module.getOrInsertFunction("vire_profile_enter", llvm::FunctionType::get(void_ty, {ptr_ty, ptr_ty}, false));
+        exit_func=module.getOrInsertFunction("vire_profile_exit", llvm::FunctionType::get(void_ty, {ptr_ty}, false));
+
+        for(auto* func : {enter_func.getCallee(), exit_func.getCallee()})
+        {
+            if(auto* function=llvm::dyn_cast<llvm::Function>(func))
+            {
+                function->setDoesNotThrow();
+                function->setWillReturn();
+            }
+        }
+    }
+
+    VProfiler::Site VProfiler::createSite(std::string const& name)
+    {
+        auto& ctx=module.getContext();
+        auto* ptr_ty=llvm::PointerType::get(ctx, 0);
+
+        auto* slot=new llvm::GlobalVariable(module, ptr_ty, false, llvm::GlobalValue::InternalLinkage,
+            llvm::ConstantPointerNull::get(ptr_ty), "vire.profile.site");
+
+        auto* str=llvm::ConstantDataArray::getString(ctx, name);
+        auto* name_var=new llvm::GlobalVariable(module, str->getType(), true, llvm::GlobalValue::PrivateLinkage, str, "vire.profile.name");
+        name_var->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+
+        return {slot, name_var};
+    }
+
+    void VProfiler::enter(llvm::IRBuilderBase& builder, Site const& site)
+    {
+        builder.CreateCall(enter_func, {site.slot, site.name});
+    }
+    void VProfiler::exit(llvm::IRBuilderBase& builder, Site const& site)
+    {
+        builder.CreateCall(exit_func, {site.slot});
+    }
+}
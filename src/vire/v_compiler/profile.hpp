@@ -0,0 +1,37 @@
+#pragma once
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+
+#include <string>
+
+namespace vire
+{
+
+// VProfiler - Instruments the functions and loops of a module, created by `compileModule` when instrumentation is enabled
+// A site calls `vire_profile_enter` where it starts and `vire_profile_exit` where it ends, libvirert times them
+// and writes a flat profile and the call counts at exit
+// Each site is a null pointer the runtime sets on its first call, so the module needs no constructor
+class VProfiler
+{
+public:
+    struct Site
+    {
+        llvm::GlobalVariable* slot;
+        llvm::Constant* name;
+    };
+private:
+    llvm::Module& module;
+    llvm::FunctionCallee enter_func;
+    llvm::FunctionCallee exit_func;
+public:
+    VProfiler(llvm::Module& module);
+
+    Site createSite(std::string const& name);
+
+    // A site that is left without its exit, eg - a loop left by `return`, is closed by the exit of its function
+    void enter(llvm::IRBuilderBase& builder, Site const& site);
+    void exit(llvm::IRBuilderBase& builder, Site const& site);
+};
+
+}
@@ -0,0 +1,137 @@
+#include "reachability.hpp"
+
+namespace vire
+{
+    void VReachability::markType(types::Base* const type)
+    {
+        if(!type)
+            return;
+
+        auto* root=(type->getType()==types::EType::Array) ? types::getArrayRootType(type) : type;
+
+        // Struct types are still `Void` with the name of the struct where the analyzer did not replace them
+        std::string name;
+        if(root->getType()==types::EType::Custom)
+            name=((types::Custom*)root)->getName();
+        else if(root->getType()==types::EType::Void)
+            name=((types::Void*)root)->getName();
+
+        if(!name.empty() && analyzer->isStructDefined(name))
+        {
+            markStruct(analyzer->getStruct(name));
+        }
+    }
+    void VReachability::markStruct(StructExprAST* const st)
+    {
+        if(!st || !structs.insert(st->getName()).second)
+            return;
+
+        // Nested structs are compiled with their parent, so only their members are followed
+        for(auto const& member : st->getMembersValues())
+        {
+            if(member->asttype==ast_struct)
+            {
+                for(auto const& nested : ((StructExprAST*)member)->getMembersValues())
+                    markType(nested->getType());
+            }
+            else
+            {
+                markType(member->getType());
+            }
+        }
+
+        markFunction(st->getConstructor());
+    }
+    void VReachability::markFunction(FunctionBaseAST* const func)
+    {
+        if(!func || !functions.insert(func->getIName().name).second)
+            return;
+
+        markType(func->getReturnType());
+        for(auto const& arg : func->getArgs())
+        {
+            markType(arg->getType());
+        }
+
+        if(!func->is_extern() && !func->is_proto())
+        {
+            worklist.push_back((FunctionAST*)func);
+        }
+    }
+
+    void VReachability::markCallees(ExprAST* const expr)
+    {
+        if(expr->asttype==ast_call)
+        {
+            auto* call=(CallExprAST*)expr;
+            if(call->getBuiltin()==builtin_none)
+                markFunction(analyzer->getFunction(call->getIName().name));
+        }
+        else if(expr->asttype==ast_for)
+        {
+            // The body of a `@parallel` loop was moved into its own function
+            auto* for_=(ForExprAST*)expr;
+            if(for_->isParallel())
+                markFunction(analyzer->getFunction(for_->getOutlinedName()));
+        }
+    }
+
+    void VReachability::visit(ExprAST* const expr)
+    {
+        forEachExpr(expr, [this](ExprAST* e)
+        {
+            markType(e->getType());
+            markCallees(e);
+        });
+    }
+
+    void VReachability::analyze(ModuleAST* const mod)
+    {
+        functions.clear();
+        structs.clear();
+        worklist.clear();
+
+        FunctionBaseAST* main_func=nullptr;
+        for(auto const& func : mod->getFunctions())
+        {
+            if(!func->is_extern() && !func->is_proto() && func->getIName().name=="main")
+                main_func=func.get();
+        }
+
+        // Global statements run from the `main` codegen creates for them, even when the module has no `main` of its own
+        has_entry=(main_func!=nullptr || !mod->getPreExecutionStatements().empty());
+        if(!has_entry)
+            return;
+
+        if(main_func)
+            markFunction(main_func);
+        for(auto const& var : mod->getPreExecutionStatementsVariables())
+        {
+            markType(var->getType());
+        }
+        for(auto const& stm : mod->getPreExecutionStatements())
+        {
+            visit(stm.get());
+        }
+
+        while(!worklist.empty())
+        {
+            auto* func=worklist.back();
+            worklist.pop_back();
+
+            for(auto const& stm : func->getBody())
+            {
+                visit(stm.get());
+            }
+        }
+    }
+
+    bool VReachability::isFunctionReachable(FunctionBaseAST* const func) const
+    {
+        return !has_entry || functions.count(func->getIName().name)>0;
+    }
+    bool VReachability::isStructReachable(std::string const& name) const
+    {
+        return !has_entry || structs.count(name)>0;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vire/ast/include.hpp"
+#include "vire/v_analyzer/include.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+namespace vire
+{
+
+// VReachability - Walks the call graph of a verified module from `main` and the global statements,
+// functions and structs that are never reached are not compiled at all
+// A module without `main` and without global statements is a library for the host program, everything in it is kept
+class VReachability
+{
+    VAnalyzer* analyzer;
+    std::unordered_set<std::string> functions;
+    std::unordered_set<std::string> structs;
+    std::vector<FunctionAST*> worklist;
+    bool has_entry;
+
+    void markType(types::Base* const type);
+    void markStruct(StructExprAST* const st);
+    void markFunction(FunctionBaseAST* const func);
+    void markCallees(ExprAST* const expr);
+    void visit(ExprAST* const expr);
+public:
+    VReachability(VAnalyzer* analyzer) : analyzer(analyzer), has_entry(false) {}
+
+    void analyze(ModuleAST* const mod);
+
+    bool isFunctionReachable(FunctionBaseAST* const func) const;
+    bool isStructReachable(std::string const& name) const;
+};
+
+}